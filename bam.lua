@@ -38,7 +38,8 @@ if family == 'windows' then
 	platform = "winx64"
 else
 	platform = "linux_x86_64"
-	settings.cc.flags:Add( "-Wconversion", "-Wextra", "-Wall", "-Werror", "-Wstrict-aliasing=2" )
+	settings.cc.flags:Add( "-Wconversion", "-Wextra", "-Wall", "-Werror", "-Wstrict-aliasing=2", "-pthread" )
+	settings.link.flags:Add( "-pthread" )
 end
 
 local output_path = PathJoin( BUILD_PATH, PathJoin( platform, config ) )
@@ -47,18 +48,28 @@ settings.cc.Output = output_func
 settings.lib.Output = output_func
 settings.link.Output = output_func
 
-local tests  = Link( settings, 'url_tests', Compile( settings, 'test/url_parse_tests.cpp' ) )
+local tests  = Link( settings, 'url_tests', Compile( settings, 'test/url_parse_tests.cpp', 'test/url_router_tests.cpp', 'test/url_psl_tests.cpp' ) )
+
+local bench_settings = settings:Copy()
+bench_settings.optimize = 1
+local bench  = Link( bench_settings, 'url_bench', Compile( bench_settings, 'bench/url_parse_bench.cpp' ) )
 
 test_args = " -v"
 if ScriptArgs["test"]     then test_args = test_args .. " -t " .. ScriptArgs["test"] end
 if ScriptArgs["suite"]    then test_args = test_args .. " -s " .. ScriptArgs["suite"] end
 
+bench_args = ""
+if ScriptArgs["bench_out"]    then bench_args = bench_args .. " -o " .. ScriptArgs["bench_out"] end
+if ScriptArgs["bench_corpus"] then bench_args = bench_args .. " -c " .. ScriptArgs["bench_corpus"] end
+
 if family == "windows" then
         AddJob( "test",  "unittest",  string.gsub( tests, "/", "\\" ) .. test_args, tests, tests )
+        AddJob( "bench", "benchmark", string.gsub( bench, "/", "\\" ) .. bench_args, bench, bench )
 else
         AddJob( "test",     "unittest",  tests .. test_args, tests, tests )
         AddJob( "valgrind", "valgrind",  "valgrind -v --leak-check=full --track-origins=yes " .. tests .. test_args, tests, tests )
+        AddJob( "bench",    "benchmark", bench .. bench_args, bench, bench )
 end
 
-PseudoTarget( "all", tests, listdir )
+PseudoTarget( "all", tests, bench, listdir )
 DefaultTarget( "all" )
@@ -0,0 +1,1062 @@
+/*
+    Benchmarks for url.h
+
+	Copyright (C) 2021- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// ... count all allocations done by the parser to report allocations/url ...
+static size_t bench_num_allocs = 0;
+
+static void* bench_malloc( size_t size )
+{
+	++bench_num_allocs;
+	return malloc( size );
+}
+
+#define URL_PARSER_MALLOC( size ) bench_malloc( size )
+#define URL_PARSER_FREE( ptr )    free( ptr )
+#define URL_PARSER_IMPLEMENTATION
+#include "../url.h"
+#define URL_ROUTER_IMPLEMENTATION
+#include "../url_router.h"
+#define URL_PSL_IMPLEMENTATION
+#include "../url_psl.h"
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#  define BENCH_HAS_CYCLES 1
+static unsigned long long bench_cycles() { return __rdtsc(); }
+#elif defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+#  define BENCH_HAS_CYCLES 1
+static unsigned long long bench_cycles() { return __rdtsc(); }
+#else
+#  define BENCH_HAS_CYCLES 0
+static unsigned long long bench_cycles() { return 0; }
+#endif
+
+static double bench_now_ns()
+{
+	return (double)std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+// ... keep the optimizer from removing the work being measured ...
+static volatile size_t bench_sink;
+
+// ... if set, one json-object per result is written here so that runs can be compared ...
+static FILE* bench_json = 0x0;
+
+// ... every benchmark runs over about this many bytes of urls ...
+static const double BENCH_BYTES_PER_RUN = 32.0 * 1024.0 * 1024.0;
+
+struct bench_corpus
+{
+	const char*              name;
+	std::vector<std::string> urls;
+	size_t                   bytes;
+};
+
+struct bench_result
+{
+	size_t             num_urls;
+	size_t             num_bytes;
+	double             ns;
+	unsigned long long cycles;
+	size_t             allocs;
+};
+
+static void bench_report( const char* corpus, const char* name, const bench_result& res, const char* extra = "" )
+{
+	double ns_per_url     = res.ns / (double)res.num_urls;
+	double bytes_per_sec  = (double)res.num_bytes / ( res.ns / 1000000000.0 );
+	double allocs_per_url = (double)res.allocs / (double)res.num_urls;
+	double cycles_per_byte = (double)res.cycles / (double)res.num_bytes;
+
+	printf( "%-9s %-26s ns/url: %9.2f  MB/s: %8.1f  allocs/url: %5.2f", corpus, name, ns_per_url, bytes_per_sec / ( 1024.0 * 1024.0 ), allocs_per_url );
+	if( BENCH_HAS_CYCLES )
+		printf( "  cycles/byte: %6.3f", cycles_per_byte );
+	printf( "%s\n", extra );
+
+	if( bench_json )
+	{
+		fprintf( bench_json, "{\"corpus\": \"%s\", \"bench\": \"%s\", \"urls\": %zu, \"bytes\": %zu, \"ns_per_url\": %.3f, \"bytes_per_sec\": %.1f, \"allocs_per_url\": %.3f",
+				 corpus, name, res.num_urls, res.num_bytes, ns_per_url, bytes_per_sec, allocs_per_url );
+		if( BENCH_HAS_CYCLES )
+			fprintf( bench_json, ", \"cycles_per_byte\": %.4f", cycles_per_byte );
+		fprintf( bench_json, "}\n" );
+	}
+}
+
+/**
+ * Run func on all urls in corpus until about bytes_per_run bytes has been processed, but at least once.
+ * func is called as func( index_of_url ) and returns a value that is fed to bench_sink.
+ */
+template <typename F>
+static bench_result bench_run( const bench_corpus& corpus, F func, double bytes_per_run = BENCH_BYTES_PER_RUN )
+{
+	int iterations = (int)( bytes_per_run / (double)corpus.bytes ) + 1;
+
+	size_t sink   = 0;
+	size_t allocs = bench_num_allocs;
+	double start_ns = bench_now_ns();
+	unsigned long long start_cycles = bench_cycles();
+	for( int it = 0; it < iterations; ++it )
+		for( size_t i = 0; i < corpus.urls.size(); ++i )
+			sink += func( i );
+	unsigned long long cycles = bench_cycles() - start_cycles;
+	double ns = bench_now_ns() - start_ns;
+	bench_sink = sink;
+
+	bench_result res;
+	res.num_urls  = corpus.urls.size() * (size_t)iterations;
+	res.num_bytes = corpus.bytes * (size_t)iterations;
+	res.ns        = ns;
+	res.cycles    = cycles;
+	res.allocs    = bench_num_allocs - allocs;
+	return res;
+}
+
+/**
+ * Deterministic generator for the synthetic corpora, the same seed always give the same urls on
+ * all platforms so that results from different runs and machines can be compared.
+ */
+struct bench_rng
+{
+	unsigned int state;
+
+	unsigned int next()
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	unsigned int range( unsigned int min, unsigned int max ) { return min + next() % ( max - min + 1 ); }
+
+	const char* word()
+	{
+		static const char* WORDS[] = { "users", "items", "search", "Account", "orders", "static", "img", "api", "news", "product",
+									   "category", "session", "v2", "data", "Example", "media", "auth", "download", "archive", "index" };
+		return WORDS[next() % ( sizeof(WORDS) / sizeof(WORDS[0]) )];
+	}
+};
+
+static std::string bench_fmt( const char* fmt, unsigned int a, unsigned int b = 0 )
+{
+	char buffer[64];
+	snprintf( buffer, sizeof(buffer), fmt, a, b );
+	return buffer;
+}
+
+// ... short urls as sent to a REST-api, http/https with an explicit port now and then ...
+static std::string bench_gen_api_url( bench_rng& rng )
+{
+	std::string url = rng.next() % 2 ? "https://api." : "http://api.";
+	url += rng.word();
+	url += ".com";
+	if( rng.next() % 4 == 0 )
+		url += bench_fmt( ":%u", rng.range( 1024, 65535 ) );
+	url += "/v1/";
+	url += rng.word();
+	url += bench_fmt( "/%u", rng.range( 1, 1000000 ) );
+	if( rng.next() % 2 )
+	{
+		url += "/";
+		url += rng.word();
+	}
+	if( rng.next() % 2 )
+		url += bench_fmt( "?limit=%u&offset=%u", rng.range( 1, 100 ), rng.range( 0, 10000 ) );
+	return url;
+}
+
+// ... long urls with many parameters, as in links from newsletters and ads ...
+static std::string bench_gen_tracking_url( bench_rng& rng )
+{
+	std::string url = "https://www.";
+	url += rng.word();
+	url += ".com/landing/";
+	url += rng.word();
+	url += ".html?utm_source=newsletter&utm_medium=email&utm_campaign=";
+	url += rng.word();
+
+	unsigned int num_params = rng.range( 20, 80 );
+	for( unsigned int i = 0; i < num_params; ++i )
+	{
+		url += "&";
+		url += rng.word();
+		url += bench_fmt( "%u=%08x", i, rng.next() );
+	}
+	if( rng.next() % 2 )
+		url += bench_fmt( "#section-%u", rng.range( 1, 20 ) );
+	return url;
+}
+
+// ... ipv6 hosts, with and without user/pass and port ...
+static std::string bench_gen_ipv6_url( bench_rng& rng )
+{
+	std::string url = "http://";
+	if( rng.next() % 3 == 0 )
+	{
+		url += rng.word();
+		url += ":secret@";
+	}
+	url += bench_fmt( "[2001:db8:%x:%x", rng.range( 0, 0xffff ), rng.range( 0, 0xffff ) );
+	url += bench_fmt( "::%x:%x]", rng.range( 0, 0xffff ), rng.range( 0, 0xffff ) );
+	if( rng.next() % 2 )
+		url += bench_fmt( ":%u", rng.range( 1, 65535 ) );
+	url += "/";
+	url += rng.word();
+	url += "/";
+	url += rng.word();
+	if( rng.next() % 2 )
+	{
+		url += "?q=";
+		url += rng.word();
+	}
+	return url;
+}
+
+// ... paths where a large part of the bytes are percent-encoded, as with non-ascii file names ...
+static std::string bench_gen_encoded_url( bench_rng& rng )
+{
+	std::string url = "http://files.";
+	url += rng.word();
+	url += ".com";
+
+	unsigned int num_segments = rng.range( 2, 6 );
+	for( unsigned int seg = 0; seg < num_segments; ++seg )
+	{
+		url += "/";
+		unsigned int seg_len = rng.range( 4, 24 );
+		for( unsigned int i = 0; i < seg_len; ++i )
+		{
+			if( rng.next() % 3 == 0 )
+				url += (char)( 'a' + rng.next() % 26 );
+			else
+				url += bench_fmt( "%%%02X", rng.range( 0x20, 0xff ) );
+		}
+	}
+	url += bench_fmt( "?name=%%E3%%81%%%02X", rng.range( 0x80, 0xbf ) );
+	return url;
+}
+
+static bench_corpus bench_gen_corpus( const char* name, std::string (*gen)( bench_rng& ), unsigned int seed, size_t num_urls )
+{
+	bench_rng rng = { seed };
+	bench_corpus corpus;
+	corpus.name  = name;
+	corpus.bytes = 0;
+	for( size_t i = 0; i < num_urls; ++i )
+	{
+		corpus.urls.push_back( gen( rng ) );
+		corpus.bytes += corpus.urls.back().size();
+	}
+	return corpus;
+}
+
+static std::vector<bench_corpus> bench_corpora()
+{
+	std::vector<bench_corpus> corpora;
+	corpora.push_back( bench_gen_corpus( "api",      bench_gen_api_url,      0x1234u, 1024 ) );
+	corpora.push_back( bench_gen_corpus( "tracking", bench_gen_tracking_url, 0x2345u, 256 ) );
+	corpora.push_back( bench_gen_corpus( "ipv6",     bench_gen_ipv6_url,     0x3456u, 1024 ) );
+	corpora.push_back( bench_gen_corpus( "encoded",  bench_gen_encoded_url,  0x4567u, 1024 ) );
+
+	bench_corpus mixed;
+	mixed.name  = "mixed";
+	mixed.bytes = 0;
+	for( size_t i = 0; i < corpora.size(); ++i )
+	{
+		mixed.urls.insert( mixed.urls.end(), corpora[i].urls.begin(), corpora[i].urls.end() );
+		mixed.bytes += corpora[i].bytes;
+	}
+	corpora.push_back( mixed );
+	return corpora;
+}
+
+/**
+ * Boundary search as it was done before the single-pass scanner, one strchr/strpbrk/strlen per
+ * component. Kept as a reference to compare the scanner against. If visited is non-null the
+ * number of bytes looked at by the string functions is added to it.
+ */
+static const char* legacy_strchr( const char* s, int c, size_t* visited )
+{
+	const char* r = strchr( s, c );
+	if( visited )
+		*visited += ( r ? (size_t)( r - s ) : strlen( s ) ) + 1;
+	return r;
+}
+
+static const char* legacy_strpbrk( const char* s, const char* set, size_t* visited )
+{
+	const char* r = strpbrk( s, set );
+	if( visited )
+		*visited += ( r ? (size_t)( r - s ) : strlen( s ) ) + 1;
+	return r;
+}
+
+static size_t legacy_strlen( const char* s, size_t* visited )
+{
+	size_t len = strlen( s );
+	if( visited )
+		*visited += len + 1;
+	return len;
+}
+
+static size_t legacy_find_boundaries( const char* url, size_t* visited )
+{
+	size_t res = 0;
+
+	// ... scheme ...
+	const char* schemesep = legacy_strchr( url, ':', visited );
+	if( schemesep && schemesep[1] == '/' )
+	{
+		if( schemesep[2] != '/' )
+			return 0;
+		url = schemesep + 3;
+	}
+
+	// ... user/pass ...
+	const char* atpos = legacy_strchr( url, '@', visited );
+	if( atpos )
+		url = atpos + 1;
+
+	// ... host/port ...
+	const char* portsep = legacy_strchr( url, ':', visited );
+	const char* pathsep = legacy_strchr( url, '/', visited );
+	if( portsep && !( pathsep && pathsep < portsep ) )
+	{
+		res += (size_t)atoi( portsep + 1 );
+		pathsep = legacy_strchr( portsep, '/', visited );
+	}
+
+	// ... path ...
+	if( pathsep )
+	{
+		const char* path_end = legacy_strpbrk( pathsep, "?#", visited );
+		url = path_end ? path_end : pathsep + legacy_strlen( pathsep, visited );
+	}
+
+	// ... query ...
+	if( *url == '?' )
+	{
+		const char* fragment_start = legacy_strchr( url, '#', visited );
+		url = fragment_start ? fragment_start : url + legacy_strlen( url, visited );
+	}
+
+	// ... fragment ...
+	if( *url == '#' )
+		url += legacy_strlen( url, visited );
+
+	return res + (size_t)url;
+}
+
+static size_t legacy_no_count( const char* url ) { return legacy_find_boundaries( url, 0x0 ); }
+
+static size_t scanner_find_boundaries( const char* url, size_t len, parse_url_delim_mask_func kernel )
+{
+	parsed_url_view view;
+	if( !parse_url_scan_url( url, len, &view, kernel ) )
+		return 0;
+	return view.path.offset + view.query.offset + view.fragment.offset + view.port;
+}
+
+/**
+ * Find the range of the explicit port in view, if any. This is what the scan passes to parse_url_parse_port().
+ */
+static parsed_url_range bench_port_range( const parsed_url_view& view )
+{
+	parsed_url_range range = { 0, 0 };
+	if( ( view.flags & PARSED_URL_VIEW_HAS_HOST ) == 0 )
+		return range;
+
+	const char* url = view.url;
+	size_t pos = view.host.offset + view.host.length;
+	if( url[pos] == ']' )
+		++pos;
+	if( url[pos] != ':' )
+		return range;
+
+	range.offset = pos + 1;
+	while( url[range.offset + range.length] >= '0' && url[range.offset + range.length] <= '9' )
+		++range.length;
+	return range;
+}
+
+/**
+ * Benchmark each phase of parse_url() on its own. The scan is measured by itself and the other
+ * phases run the same code as parse_url_alloc_components() does for that component, over views
+ * and ports found before the timing starts.
+ */
+static void bench_phases( const bench_corpus& corpus )
+{
+	std::vector<parsed_url_view>  views( corpus.urls.size() );
+	std::vector<parsed_url_range> ports( corpus.urls.size() );
+	for( size_t i = 0; i < corpus.urls.size(); ++i )
+	{
+		if( !parse_url_view_n( corpus.urls[i].c_str(), corpus.urls[i].size(), &views[i] ) )
+		{
+			fprintf( stderr, "failed to parse url in corpus %s: %s\n", corpus.name, corpus.urls[i].c_str() );
+			exit( 1 );
+		}
+		ports[i] = bench_port_range( views[i] );
+	}
+
+	char scratch[8192];
+
+	bench_report( corpus.name, "phase: scan", bench_run( corpus, [&]( size_t i ) {
+		parsed_url_view view;
+		return parse_url_view_n( corpus.urls[i].c_str(), corpus.urls[i].size(), &view ) ? view.port : 0u;
+	} ) );
+
+	bench_report( corpus.name, "phase: scheme", bench_run( corpus, [&]( size_t i ) {
+		const parsed_url_view& v = views[i];
+		parse_url_ctx ctx = { scratch, sizeof(scratch), sizeof(scratch) };
+		const char* scheme = parse_url_alloc_lower_string( &ctx, v.url + v.scheme.offset, v.scheme.length );
+		unsigned int port;
+		return (size_t)parse_url_lookup_scheme( v.url + v.scheme.offset, v.scheme.length, &port ) + port + (size_t)scheme[0];
+	} ) );
+
+	bench_report( corpus.name, "phase: user/pass", bench_run( corpus, [&]( size_t i ) {
+		const parsed_url_view& v = views[i];
+		parse_url_ctx ctx = { scratch, sizeof(scratch), sizeof(scratch) };
+		const char* user = parse_url_alloc_string( &ctx, v.url + v.user.offset, v.user.length );
+		const char* pass = parse_url_alloc_string( &ctx, v.url + v.pass.offset, v.pass.length );
+		return (size_t)user[0] + (size_t)pass[0];
+	} ) );
+
+	bench_report( corpus.name, "phase: host/port", bench_run( corpus, [&]( size_t i ) {
+		const parsed_url_view& v = views[i];
+		parse_url_ctx ctx = { scratch, sizeof(scratch), sizeof(scratch) };
+		const char* host = parse_url_alloc_lower_string( &ctx, v.url + v.host.offset, v.host.length );
+		unsigned int port = 0;
+		parse_url_parse_port( v.url, ports[i].offset, ports[i].offset + ports[i].length, &port );
+		return (size_t)host[0] + port;
+	} ) );
+
+	bench_report( corpus.name, "phase: path+decode", bench_run( corpus, [&]( size_t i ) {
+		const parsed_url_view& v = views[i];
+		parse_url_ctx ctx = { scratch, sizeof(scratch), sizeof(scratch) };
+		const char* path = parse_url_alloc_decoded_string( &ctx, v.url + v.path.offset, v.path.length );
+		return path ? (size_t)path[0] : 0;
+	} ) );
+
+	bench_report( corpus.name, "phase: query", bench_run( corpus, [&]( size_t i ) {
+		const parsed_url_view& v = views[i];
+		parse_url_ctx ctx = { scratch, sizeof(scratch), sizeof(scratch) };
+		return (size_t)parse_url_alloc_string( &ctx, v.url + v.query.offset, v.query.length )[0];
+	} ) );
+
+	bench_report( corpus.name, "phase: query params", bench_run( corpus, [&]( size_t i ) {
+		const parsed_url_view& v = views[i];
+		parse_url_query_iter it;
+		parse_url_query_iter_init( &it, v.url + v.query.offset, v.query.length );
+		size_t res = 0;
+		parsed_url_query_param param;
+		while( parse_url_query_next( &it, &param ) )
+			res += param.key_len + param.value_len;
+		return res;
+	} ) );
+
+	bench_report( corpus.name, "phase: fragment", bench_run( corpus, [&]( size_t i ) {
+		const parsed_url_view& v = views[i];
+		parse_url_ctx ctx = { scratch, sizeof(scratch), sizeof(scratch) };
+		return (size_t)parse_url_alloc_string( &ctx, v.url + v.fragment.offset, v.fragment.length )[0];
+	} ) );
+}
+
+static void bench_end_to_end( const bench_corpus& corpus )
+{
+	char buffer[8192];
+
+	bench_report( corpus.name, "parse_url_n", bench_run( corpus, [&]( size_t i ) {
+		parsed_url* parsed = parse_url_n( corpus.urls[i].c_str(), corpus.urls[i].size(), buffer, sizeof(buffer) );
+		return parsed ? (size_t)parsed->port : 0;
+	} ) );
+
+	bench_report( corpus.name, "parse_url_n, lazy decode", bench_run( corpus, [&]( size_t i ) {
+		parsed_url* parsed = parse_url_n( corpus.urls[i].c_str(), corpus.urls[i].size(), buffer, sizeof(buffer), PARSE_URL_FLAG_LAZY_DECODE );
+		return parsed ? (size_t)parsed->port : 0;
+	} ) );
+
+	bench_report( corpus.name, "parse_url_n, normalize", bench_run( corpus, [&]( size_t i ) {
+		parsed_url* parsed = parse_url_n( corpus.urls[i].c_str(), corpus.urls[i].size(), buffer, sizeof(buffer), PARSE_URL_FLAG_NORMALIZE_PATH | PARSE_URL_FLAG_COLLAPSE_SLASHES );
+		return parsed ? (size_t)parsed->port : 0;
+	} ) );
+
+	bench_report( corpus.name, "parse_url + free", bench_run( corpus, [&]( size_t i ) {
+		parsed_url* parsed = parse_url( corpus.urls[i].c_str(), 0x0, 0 );
+		size_t res = parsed ? (size_t)parsed->port : 0;
+		URL_PARSER_FREE( parsed );
+		return res;
+	} ) );
+
+	// ... sizing the memory before parsing, as an upper bound from the url or exact from the view ...
+	size_t bound_bytes = 0;
+	size_t exact_bytes = 0;
+	for( size_t i = 0; i < corpus.urls.size(); ++i )
+	{
+		parsed_url_view view;
+		bound_bytes += parse_url_calc_mem_usage_n( corpus.urls[i].c_str(), corpus.urls[i].size() );
+		exact_bytes += parse_url_view_n( corpus.urls[i].c_str(), corpus.urls[i].size(), &view ) ? parse_url_view_calc_mem_usage( &view ) : 0;
+	}
+
+	char extra[64];
+	snprintf( extra, sizeof(extra), "  bytes/url: %.1f", (double)bound_bytes / (double)corpus.urls.size() );
+	bench_report( corpus.name, "calc_mem_usage + parse", bench_run( corpus, [&]( size_t i ) {
+		size_t size = parse_url_calc_mem_usage_n( corpus.urls[i].c_str(), corpus.urls[i].size() );
+		parsed_url* parsed = parse_url_n( corpus.urls[i].c_str(), corpus.urls[i].size(), buffer, size );
+		return parsed ? (size_t)parsed->port : 0;
+	} ), extra );
+
+	snprintf( extra, sizeof(extra), "  bytes/url: %.1f", (double)exact_bytes / (double)corpus.urls.size() );
+	bench_report( corpus.name, "view + exact + from_view", bench_run( corpus, [&]( size_t i ) {
+		parsed_url_view view;
+		if( !parse_url_view_n( corpus.urls[i].c_str(), corpus.urls[i].size(), &view ) )
+			return (size_t)0;
+		parsed_url* parsed = parse_url_from_view( &view, buffer, parse_url_view_calc_mem_usage( &view ) );
+		return parsed ? (size_t)parsed->port : 0;
+	} ), extra );
+
+	// ... request-scoped parsing, urls parsed into one arena that is reset every 32 urls ...
+	parse_url_arena arena;
+	parse_url_arena_init( &arena, 16 * 1024 );
+	char arena_extra[64];
+	bench_result arena_res = bench_run( corpus, [&]( size_t i ) {
+		if( i % 32 == 0 )
+			parse_url_arena_reset( &arena );
+		parsed_url* parsed = parse_url_arena_parse_n( &arena, corpus.urls[i].c_str(), corpus.urls[i].size() );
+		return parsed ? (size_t)parsed->port : 0;
+	} );
+	snprintf( arena_extra, sizeof(arena_extra), "  high-water: %.1f kb", (double)arena.high_water / 1024.0 );
+	bench_report( corpus.name, "arena, reset per 32", arena_res, arena_extra );
+	parse_url_arena_destroy( &arena );
+
+	parse_url_buffer<2048> stack_buffer;
+	bench_report( corpus.name, "parse_url_buffer<2048>", bench_run( corpus, [&]( size_t i ) {
+		parsed_url* parsed = stack_buffer.parse_n( corpus.urls[i].c_str(), corpus.urls[i].size() );
+		return parsed ? (size_t)parsed->port : 0;
+	} ) );
+}
+
+static void bench_boundaries( const bench_corpus& corpus )
+{
+	// ... average number of times each byte of the url is looked at by the legacy search ...
+	size_t visited = 0;
+	size_t bytes   = 0;
+	for( size_t i = 0; i < corpus.urls.size(); ++i )
+	{
+		legacy_find_boundaries( corpus.urls[i].c_str(), &visited );
+		bytes += corpus.urls[i].size() + 1;
+	}
+
+	char passes[32];
+	snprintf( passes, sizeof(passes), "  passes: %.2f", (double)visited / (double)bytes );
+	bench_report( corpus.name, "boundaries: legacy strchr", bench_run( corpus, [&]( size_t i ) {
+		return legacy_no_count( corpus.urls[i].c_str() );
+	} ), passes );
+
+	bench_report( corpus.name, "boundaries: scan, scalar", bench_run( corpus, [&]( size_t i ) {
+		return scanner_find_boundaries( corpus.urls[i].c_str(), corpus.urls[i].size(), parse_url_delim_mask_scalar );
+	} ) );
+
+	bench_report( corpus.name, "boundaries: scan, simd", bench_run( corpus, [&]( size_t i ) {
+		return scanner_find_boundaries( corpus.urls[i].c_str(), corpus.urls[i].size(), parse_url_delim_mask_kernel() );
+	} ) );
+}
+
+static void bench_batch( const bench_corpus& corpus )
+{
+	std::vector<const char*> urls;
+	for( size_t i = 0; i < corpus.urls.size(); ++i )
+		urls.push_back( corpus.urls[i].c_str() );
+	std::vector<parsed_url*> out( urls.size() );
+
+	// ... the arena is sized once and reused between batches, bench_run() calls the lambda once per url so only do work on the first ...
+	size_t mem_size = parse_url_batch_calc_mem_usage( &urls[0], urls.size() );
+	void* mem = malloc( mem_size );
+
+	bench_report( corpus.name, "parse_url_batch", bench_run( corpus, [&]( size_t i ) {
+		return i == 0 ? parse_url_batch( &urls[0], urls.size(), mem, mem_size, &out[0] ) : 0;
+	} ) );
+
+	char threads[32];
+	snprintf( threads, sizeof(threads), "  threads: %u", std::thread::hardware_concurrency() );
+	bench_report( corpus.name, "parse_url_batch_parallel", bench_run( corpus, [&]( size_t i ) {
+		return i == 0 ? parse_url_batch_parallel( &urls[0], urls.size(), mem, mem_size, &out[0], 0 ) : 0;
+	} ), threads );
+	free( mem );
+}
+
+/**
+ * Memory needed to keep all urls of corpus resident, as parsed_url with an exactly sized arena
+ * compared to parsed_url_compact and its share of the string pool.
+ */
+static void bench_compact( const bench_corpus& corpus )
+{
+	size_t parsed_bytes = 0;
+	size_t pool_bytes   = 0;
+	for( size_t i = 0; i < corpus.urls.size(); ++i )
+	{
+		parsed_url_view view;
+		if( !parse_url_view_n( corpus.urls[i].c_str(), corpus.urls[i].size(), &view ) )
+			continue;
+
+		char mem[4096];
+		size_t exact = parse_url_view_calc_mem_usage( &view );
+		parsed_url* parsed = parse_url_from_view( &view, mem, exact );
+		if( parsed == 0x0 )
+			continue;
+		parsed_bytes += exact;
+		pool_bytes   += parse_url_compact_pool_usage( parsed );
+	}
+
+	std::vector<char> pool_mem( pool_bytes );
+	std::vector<parsed_url_compact> compact( corpus.urls.size() );
+	parse_url_string_pool pool;
+
+	double num_urls       = (double)corpus.urls.size();
+	double compact_bytes  = (double)( sizeof( parsed_url_compact ) * corpus.urls.size() + pool_bytes );
+	char   extra[128];
+	snprintf( extra, sizeof(extra), "  bytes/url: %.1f, parsed_url + arena: %.1f", compact_bytes / num_urls, (double)parsed_bytes / num_urls );
+	bench_report( corpus.name, "parse_url + compact", bench_run( corpus, [&]( size_t i ) {
+		if( i == 0 )
+			parse_url_string_pool_init( &pool, pool_mem.data(), pool_mem.size() );
+		char mem[4096];
+		parsed_url* parsed = parse_url_n( corpus.urls[i].c_str(), corpus.urls[i].size(), mem, sizeof(mem) );
+		return parsed && parse_url_compact( parsed, &pool, &compact[i] ) ? (size_t)compact[i].lengths[PARSE_URL_COMPONENT_HOST] : 0;
+	} ), extra );
+}
+
+/**
+ * Look up 10 keys per query in queries with 5, 50 and 200 parameters, some of the keys are not
+ * present. Compares a linear search over the query per key with an index built once per query.
+ */
+static void bench_query_lookup()
+{
+	static const size_t NUM_PARAMS[] = { 5, 50, 200 };
+	static const int    NUM_LOOKUPS  = 10;
+
+	for( size_t n = 0; n < sizeof(NUM_PARAMS) / sizeof(NUM_PARAMS[0]); ++n )
+	{
+		size_t num_params = NUM_PARAMS[n];
+
+		char name[32];
+		snprintf( name, sizeof(name), "params%d", (int)num_params );
+
+		bench_rng rng = { 0x5678u + (unsigned int)n };
+		bench_corpus corpus;
+		corpus.name  = name;
+		corpus.bytes = 0;
+		for( int q = 0; q < 64; ++q )
+		{
+			std::string query;
+			for( size_t i = 0; i < num_params; ++i )
+			{
+				query += i == 0 ? "" : "&";
+				query += bench_fmt( "key%u=%08x", (unsigned int)i, rng.next() );
+			}
+			corpus.urls.push_back( query );
+			corpus.bytes += query.size();
+		}
+
+		// ... the keys to look for, spread over the query with every other one missing ...
+		std::vector<std::string> keys;
+		for( int k = 0; k < NUM_LOOKUPS; ++k )
+		{
+			size_t param = (size_t)k * num_params / NUM_LOOKUPS;
+			keys.push_back( bench_fmt( k % 2 == 0 ? "missing%u" : "key%u", (unsigned int)param ) );
+		}
+
+		bench_report( name, "lookup: linear scan", bench_run( corpus, [&]( size_t i ) {
+			size_t res = 0;
+			for( int k = 0; k < NUM_LOOKUPS; ++k )
+			{
+				parse_url_query_iter it;
+				parse_url_query_iter_init( &it, corpus.urls[i].c_str(), corpus.urls[i].size() );
+				parsed_url_query_param param;
+				while( parse_url_query_next( &it, &param ) )
+					if( param.key_len == keys[(size_t)k].size() && memcmp( param.key, keys[(size_t)k].c_str(), param.key_len ) == 0 )
+					{
+						res += param.value_len;
+						break;
+					}
+			}
+			return res;
+		} ) );
+
+		char mem[8192];
+		bench_report( name, "lookup: split + index", bench_run( corpus, [&]( size_t i ) {
+			parsed_url_query_param params[256];
+			size_t count = parse_url_query_split( corpus.urls[i].c_str(), corpus.urls[i].size(), params, 256 );
+			const parse_url_query_index* index = parse_url_query_index_build( params, count, mem, sizeof(mem) );
+			size_t res = 0;
+			for( int k = 0; k < NUM_LOOKUPS; ++k )
+			{
+				const parsed_url_query_param* param = parse_url_query_index_get( index, keys[(size_t)k].c_str(), keys[(size_t)k].size() );
+				res += param ? param->value_len : 0;
+			}
+			return res;
+		} ) );
+	}
+}
+
+static void bench_resolve()
+{
+	// ... links as found on a crawled page, resolved against the url of the page ...
+	static const char* const LINKS[] = { "/", "/about", "../index.html", "page2.html", "./img/logo.png", "?page=3", "#comments",
+										 "//cdn.testurl.com/js/app.js", "https://other.com/x", "../../a/b/./c/../d.html" };
+	static const char* const PAGE = "https://www.testurl.com/blog/2021/07/post.html?ref=front";
+
+	bench_corpus corpus;
+	corpus.name  = "resolve";
+	corpus.bytes = 0;
+	for( size_t i = 0; i < sizeof(LINKS) / sizeof(LINKS[0]); ++i )
+	{
+		corpus.urls.push_back( LINKS[i] );
+		corpus.bytes += corpus.urls.back().size();
+	}
+
+	char base_mem[1024];
+	parsed_url* base = parse_url( PAGE, base_mem, sizeof(base_mem) );
+
+	char mem[2048];
+	bench_report( corpus.name, "concat + parse_url", bench_run( corpus, [&]( size_t i ) {
+		// ... what a crawler without resolve does, glue the link to the page url and parse the whole thing ...
+		const std::string& link = corpus.urls[i];
+		std::string url;
+		if( link.find( "://" ) != std::string::npos )
+			url = link;
+		else if( link.compare( 0, 2, "//" ) == 0 )
+			url = std::string( base->scheme ) + ":" + link;
+		else if( link[0] == '/' )
+			url = std::string( base->scheme ) + "://" + base->host + link;
+		else
+		{
+			std::string page( PAGE );
+			url = page.substr( 0, page.rfind( '/' ) + 1 ) + link;
+		}
+		parsed_url* parsed = parse_url_n( url.c_str(), url.size(), mem, sizeof(mem) );
+		return parsed ? (size_t)parsed->path[0] : 0;
+	} ) );
+
+	bench_report( corpus.name, "parse_url_resolve", bench_run( corpus, [&]( size_t i ) {
+		parsed_url* parsed = parse_url_resolve_n( base, corpus.urls[i].c_str(), corpus.urls[i].size(), mem, sizeof(mem) );
+		return parsed ? (size_t)parsed->path[0] : 0;
+	} ) );
+}
+
+/**
+ * The way routing is done without a router, try all routes in order and take the first that matches.
+ */
+static bool bench_linear_route_match( const char* route, const char* path, size_t path_len )
+{
+	parse_url_path_iter route_it;
+	parse_url_path_iter path_it;
+	parse_url_path_iter_init( &route_it, route, strlen( route ) );
+	parse_url_path_iter_init( &path_it, path, path_len );
+
+	parsed_url_path_segment r;
+	parsed_url_path_segment p;
+	while( parse_url_path_next( &route_it, &r ) )
+	{
+		if( r.str[0] == '*' )
+			return true;
+		if( !parse_url_path_next( &path_it, &p ) )
+			return false;
+		if( r.str[0] != ':' && ( r.len != p.len || memcmp( r.str, p.str, r.len ) != 0 ) )
+			return false;
+	}
+	return !parse_url_path_next( &path_it, &p );
+}
+
+static void bench_router()
+{
+	static const size_t      NUM_ROUTES[] = { 100, 10000, 100000 };
+	static const char* const NAMES[][2]   = { { "linear scan, 100",  "url_router_match, 100"  },
+											  { "linear scan, 10k",  "url_router_match, 10k"  },
+											  { "linear scan, 100k", "url_router_match, 100k" } };
+
+	for( size_t n = 0; n < sizeof(NUM_ROUTES) / sizeof(NUM_ROUTES[0]); ++n )
+	{
+		size_t num_routes = NUM_ROUTES[n];
+
+		// ... routes as for a large api, versioned resources with ids and some static file trees ...
+		bench_rng rng = { 0x4321u + (unsigned int)n };
+		std::vector<std::string> route_strs;
+		for( size_t r = 0; r < num_routes; ++r )
+		{
+			std::string route = bench_fmt( "/api/v%u/", rng.range( 1, 3 ) ) + rng.word() + bench_fmt( "%u", (unsigned int)r );
+			switch( rng.next() % 4 )
+			{
+				case 0:  break;
+				case 1:  route += "/:id"; break;
+				case 2:  route += std::string( "/:id/" ) + rng.word(); break;
+				default: route += "/files/*path"; break;
+			}
+			route_strs.push_back( route );
+		}
+		std::vector<const char*> routes;
+		for( size_t r = 0; r < num_routes; ++r )
+			routes.push_back( route_strs[r].c_str() );
+
+		// ... paths hitting random routes, parameters replaced with values ...
+		bench_corpus corpus;
+		corpus.name  = "router";
+		corpus.bytes = 0;
+		for( int p = 0; p < 1000; ++p )
+		{
+			std::string path = route_strs[rng.next() % num_routes];
+			size_t param;
+			while( ( param = path.find( ":id" ) ) != std::string::npos )
+				path.replace( param, 3, bench_fmt( "%u", rng.next() % 100000 ) );
+			if( ( param = path.find( "*path" ) ) != std::string::npos )
+				path.replace( param, 5, "img/logo.png" );
+			corpus.urls.push_back( path );
+			corpus.bytes += path.size();
+		}
+
+		// ... a linear scan is slow enough to only run once over the paths ...
+		bench_report( corpus.name, NAMES[n][0], bench_run( corpus, [&]( size_t i ) {
+			for( size_t r = 0; r < num_routes; ++r )
+				if( bench_linear_route_match( routes[r], corpus.urls[i].c_str(), corpus.urls[i].size() ) )
+					return r;
+			return (size_t)0;
+		}, 0.0 ) );
+
+		std::vector<char> mem( url_router_calc_mem_usage( routes.data(), num_routes ) );
+		double build_start = bench_now_ns();
+		const url_router* router = url_router_build( routes.data(), num_routes, mem.data(), mem.size() );
+		double build_ms = ( bench_now_ns() - build_start ) / 1000000.0;
+
+		char extra[64];
+		snprintf( extra, sizeof(extra), "  build: %.1f ms, %.1f kb", build_ms, (double)mem.size() / 1024.0 );
+		bench_report( corpus.name, NAMES[n][1], bench_run( corpus, [&]( size_t i ) {
+			url_router_result res;
+			return url_router_match( router, corpus.urls[i].c_str(), corpus.urls[i].size(), &res ) ? res.route : 0;
+		} ), extra );
+	}
+}
+
+/**
+ * The way public suffixes are usually found, all rules in a hash-set and every suffix of the host
+ * looked up in it from the left, returns the number of labels in the public suffix.
+ */
+static size_t bench_hashed_public_suffix( const std::unordered_set<std::string>& rules, const std::string& host )
+{
+	size_t num_labels = 1;
+	for( size_t i = 0; i < host.size(); ++i )
+		num_labels += host[i] == '.' ? 1 : 0;
+
+	std::string suffix;
+	for( size_t start = 0, labels = num_labels; labels > 0; start = host.find( '.', start ) + 1, --labels )
+	{
+		suffix.assign( host, start, std::string::npos );
+		if( rules.count( "!" + suffix ) )
+			return labels - 1;
+		if( rules.count( suffix ) )
+			return labels;
+		size_t dot = suffix.find( '.' );
+		if( dot != std::string::npos && rules.count( "*" + suffix.substr( dot ) ) )
+			return labels;
+	}
+	return 1;
+}
+
+static void bench_psl( const char* psl_path )
+{
+	// ... a list of about the same size as the real one, or the real one if there is one on disk ...
+	static const char* const TLDS[] = { "com", "net", "org", "io", "de", "uk", "co.uk", "ac.uk", "jp", "ac.jp", "kyoto.jp",
+										"*.kobe.jp", "!city.kobe.jp", "*.ck", "!www.ck", "se", "fr", "us", "ak.us", "k12.ak.us" };
+	std::string list;
+	if( psl_path )
+	{
+		FILE* f = fopen( psl_path, "rb" );
+		if( f == 0x0 )
+		{
+			fprintf( stderr, "failed to open %s\n", psl_path );
+			return;
+		}
+		char buf[4096];
+		size_t read;
+		while( ( read = fread( buf, 1, sizeof(buf), f ) ) > 0 )
+			list.append( buf, read );
+		fclose( f );
+	}
+	else
+	{
+		bench_rng rng = { 0x9876u };
+		for( size_t t = 0; t < sizeof(TLDS) / sizeof(TLDS[0]); ++t )
+			list += std::string( TLDS[t] ) + "\n";
+		for( unsigned int r = 0; r < 9000; ++r )
+			list += std::string( rng.word() ) + bench_fmt( "%u.", r ) + TLDS[rng.next() % 6] + "\n";
+		for( size_t c = 0; c < list.size(); ++c )
+			list[c] = (char)( list[c] >= 'A' && list[c] <= 'Z' ? list[c] - 'A' + 'a' : list[c] );
+	}
+
+	// ... hosts under the rules, with a few labels in front ...
+	std::vector<std::string> suffixes;
+	std::unordered_set<std::string> rules;
+	{
+		size_t      pos = 0;
+		const char* rule;
+		size_t      rule_len;
+		while( url_psl_next_rule( list.c_str(), list.size(), &pos, &rule, &rule_len ) )
+		{
+			rules.insert( std::string( rule, rule_len ) );
+			if( rule[0] == '!' )
+				suffixes.push_back( std::string( rule + 1, rule_len - 1 ) );
+			else if( rule[0] == '*' && rule_len > 2 )
+				suffixes.push_back( std::string( "x" ) + std::string( rule + 1, rule_len - 1 ) );
+			else
+				suffixes.push_back( std::string( rule, rule_len ) );
+		}
+	}
+
+	bench_rng    rng = { 0x1234u };
+	bench_corpus corpus;
+	corpus.name  = "psl";
+	corpus.bytes = 0;
+	for( int h = 0; h < 1000000; ++h )
+	{
+		std::string host;
+		switch( rng.next() % 4 )
+		{
+			case 0:  host = "www."; break;
+			case 1:  host = std::string( rng.word() ) + "." + rng.word() + "."; break;
+			default: break;
+		}
+		host += bench_fmt( "site%u.", rng.next() % 100000 ) + suffixes[rng.next() % suffixes.size()];
+		for( size_t c = 0; c < host.size(); ++c )
+			host[c] = (char)( host[c] >= 'A' && host[c] <= 'Z' ? host[c] - 'A' + 'a' : host[c] );
+		corpus.urls.push_back( host );
+		corpus.bytes += host.size();
+	}
+
+	bench_report( corpus.name, "hashed suffix lookup", bench_run( corpus, [&]( size_t i ) {
+		return bench_hashed_public_suffix( rules, corpus.urls[i] );
+	}, 0.0 ) );
+
+	std::vector<char> mem( url_psl_calc_mem_usage( list.c_str(), list.size() ) );
+	double build_start = bench_now_ns();
+	const url_psl* psl = url_psl_build( list.c_str(), list.size(), mem.data(), mem.size() );
+	double build_ms = ( bench_now_ns() - build_start ) / 1000000.0;
+
+	char extra[64];
+	snprintf( extra, sizeof(extra), "  build: %.1f ms, %.1f kb", build_ms, (double)mem.size() / 1024.0 );
+	bench_report( corpus.name, "url_psl_registrable_domain", bench_run( corpus, [&]( size_t i ) {
+		parsed_url_range range;
+		return url_psl_registrable_domain( psl, corpus.urls[i].c_str(), corpus.urls[i].size(), &range ) ? range.length : 0;
+	}, 0.0 ), extra );
+}
+
+static void bench_print_usage( const char* prog )
+{
+	printf( "usage: %s [-o <file>] [-c <corpus>] [-p <file>]\n", prog );
+	printf( "  -o <file>    write results as one json-object per line to file\n" );
+	printf( "  -c <corpus>  only run corpus, one of api, tracking, ipv6, encoded, mixed, query, resolve, router or psl\n" );
+	printf( "  -p <file>    public suffix list to use for psl, a generated list is used if not set\n" );
+}
+
+int main( int argc, char** argv )
+{
+	const char* json_path   = 0x0;
+	const char* only_corpus = 0x0;
+	const char* psl_path    = 0x0;
+	for( int i = 1; i < argc; ++i )
+	{
+		if( strcmp( argv[i], "-o" ) == 0 && i + 1 < argc )
+			json_path = argv[++i];
+		else if( strcmp( argv[i], "-c" ) == 0 && i + 1 < argc )
+			only_corpus = argv[++i];
+		else if( strcmp( argv[i], "-p" ) == 0 && i + 1 < argc )
+			psl_path = argv[++i];
+		else
+		{
+			bench_print_usage( argv[0] );
+			return 1;
+		}
+	}
+
+	if( json_path )
+	{
+		bench_json = fopen( json_path, "w" );
+		if( bench_json == 0x0 )
+		{
+			fprintf( stderr, "failed to open %s\n", json_path );
+			return 1;
+		}
+	}
+
+	std::vector<bench_corpus> corpora = bench_corpora();
+	for( size_t i = 0; i < corpora.size(); ++i )
+	{
+		const bench_corpus& corpus = corpora[i];
+		if( only_corpus && strcmp( only_corpus, corpus.name ) != 0 )
+			continue;
+
+		printf( "corpus %s, %d urls, %.1f bytes/url:\n", corpus.name, (int)corpus.urls.size(), (double)corpus.bytes / (double)corpus.urls.size() );
+		bench_phases( corpus );
+		bench_end_to_end( corpus );
+		bench_boundaries( corpus );
+		bench_batch( corpus );
+		bench_compact( corpus );
+		printf( "\n" );
+	}
+
+	if( only_corpus == 0x0 || strcmp( only_corpus, "query" ) == 0 )
+	{
+		printf( "query parameter lookup, %d keys per query:\n", 10 );
+		bench_query_lookup();
+	}
+
+	if( only_corpus == 0x0 || strcmp( only_corpus, "resolve" ) == 0 )
+	{
+		printf( "resolve links against a page url:\n" );
+		bench_resolve();
+	}
+
+	if( only_corpus == 0x0 || strcmp( only_corpus, "router" ) == 0 )
+	{
+		printf( "route paths with 100, 10k and 100k routes:\n" );
+		bench_router();
+	}
+
+	if( only_corpus == 0x0 || strcmp( only_corpus, "psl" ) == 0 )
+	{
+		printf( "registrable domain of 1M hosts:\n" );
+		bench_psl( psl_path );
+	}
+
+	if( bench_json )
+		fclose( bench_json );
+	return 0;
+}
@@ -0,0 +1,368 @@
+/*
+    Public suffix list lookup of hosts.
+
+    version 1.0, July, 2021
+
+	Copyright (C) 2021- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#define URL_PSL_IMPLEMENTATION
+
+#include "greatest.h"
+#include "../url_psl.h"
+
+#include <stdio.h>
+
+// ... a part of the real list, with the rules used by the tests at https://publicsuffix.org/list/ ...
+static const char test_psl_list[] =
+	"// ===BEGIN ICANN DOMAINS===\n"
+	"\n"
+	"com\n"
+	"biz\n"
+	"// ck : https://en.wikipedia.org/wiki/.ck\n"
+	"*.ck\n"
+	"!www.ck\n"
+	"uk\n"
+	"ac.uk\n"
+	"co.uk\n"
+	"jp\n"
+	"ac.jp\n"
+	"kyoto.jp\n"
+	"ide.kyoto.jp\n"
+	"*.kobe.jp\n"
+	"!city.kobe.jp\n"
+	"us\n"
+	"ak.us\n"
+	"k12.ak.us\n"
+	"\n"
+	"// ===BEGIN PRIVATE DOMAINS===\n"
+	"blogspot.com  // comments after the rule are ignored\r\n"
+	"github.io";
+
+static const url_psl* test_psl_build( void* mem, size_t mem_size )
+{
+	if( url_psl_calc_mem_usage( test_psl_list, sizeof(test_psl_list) - 1 ) > mem_size )
+		return 0x0;
+	return url_psl_build( test_psl_list, sizeof(test_psl_list) - 1, mem, mem_size );
+}
+
+/**
+ * Check registrable domain of host against expect, 0x0 as expect means that there should be none.
+ */
+static bool test_registrable_domain( const url_psl* psl, const char* host, const char* expect )
+{
+	parsed_url_range range;
+	bool found = url_psl_registrable_domain( psl, host, strlen( host ), &range );
+	if( expect == 0x0 )
+		return !found;
+	return found && range.length == strlen( expect ) && memcmp( host + range.offset, expect, range.length ) == 0;
+}
+
+TEST psl_registrable_domain()
+{
+	static char mem[4096];
+	const url_psl* psl = test_psl_build( mem, sizeof(mem) );
+	ASSERT( psl != 0x0 );
+
+	// ... checkPublicSuffix() from https://raw.githubusercontent.com/publicsuffix/list/master/tests/test_psl.txt ...
+	ASSERT( test_registrable_domain( psl, "com", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "example.com", "example.com" ) );
+	ASSERT( test_registrable_domain( psl, "b.example.com", "example.com" ) );
+	ASSERT( test_registrable_domain( psl, "a.b.example.com", "example.com" ) );
+
+	// ... unlisted tld ...
+	ASSERT( test_registrable_domain( psl, "example", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "example.example", "example.example" ) );
+	ASSERT( test_registrable_domain( psl, "b.example.example", "example.example" ) );
+
+	// ... tld with only one rule ...
+	ASSERT( test_registrable_domain( psl, "biz", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "domain.biz", "domain.biz" ) );
+	ASSERT( test_registrable_domain( psl, "a.b.domain.biz", "domain.biz" ) );
+
+	// ... tld with some two-level rules ...
+	ASSERT( test_registrable_domain( psl, "uk.com", "uk.com" ) );
+	ASSERT( test_registrable_domain( psl, "ac.uk", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "test.ac.uk", "test.ac.uk" ) );
+	ASSERT( test_registrable_domain( psl, "b.test.ac.uk", "test.ac.uk" ) );
+
+	// ... more complex tld ...
+	ASSERT( test_registrable_domain( psl, "jp", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "test.jp", "test.jp" ) );
+	ASSERT( test_registrable_domain( psl, "www.test.jp", "test.jp" ) );
+	ASSERT( test_registrable_domain( psl, "ac.jp", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "test.ac.jp", "test.ac.jp" ) );
+	ASSERT( test_registrable_domain( psl, "www.test.ac.jp", "test.ac.jp" ) );
+	ASSERT( test_registrable_domain( psl, "kyoto.jp", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "test.kyoto.jp", "test.kyoto.jp" ) );
+	ASSERT( test_registrable_domain( psl, "ide.kyoto.jp", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "b.ide.kyoto.jp", "b.ide.kyoto.jp" ) );
+	ASSERT( test_registrable_domain( psl, "a.b.ide.kyoto.jp", "b.ide.kyoto.jp" ) );
+	ASSERT( test_registrable_domain( psl, "c.kobe.jp", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "b.c.kobe.jp", "b.c.kobe.jp" ) );
+	ASSERT( test_registrable_domain( psl, "a.b.c.kobe.jp", "b.c.kobe.jp" ) );
+	ASSERT( test_registrable_domain( psl, "city.kobe.jp", "city.kobe.jp" ) );
+	ASSERT( test_registrable_domain( psl, "www.city.kobe.jp", "city.kobe.jp" ) );
+
+	// ... tld with a wildcard rule and exceptions ...
+	ASSERT( test_registrable_domain( psl, "ck", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "test.ck", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "b.test.ck", "b.test.ck" ) );
+	ASSERT( test_registrable_domain( psl, "a.b.test.ck", "b.test.ck" ) );
+	ASSERT( test_registrable_domain( psl, "www.ck", "www.ck" ) );
+	ASSERT( test_registrable_domain( psl, "www.www.ck", "www.ck" ) );
+
+	// ... us k12 ...
+	ASSERT( test_registrable_domain( psl, "us", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "test.us", "test.us" ) );
+	ASSERT( test_registrable_domain( psl, "www.test.us", "test.us" ) );
+	ASSERT( test_registrable_domain( psl, "ak.us", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "test.ak.us", "test.ak.us" ) );
+	ASSERT( test_registrable_domain( psl, "k12.ak.us", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "test.k12.ak.us", "test.k12.ak.us" ) );
+	ASSERT( test_registrable_domain( psl, "www.test.k12.ak.us", "test.k12.ak.us" ) );
+
+	// ... private domains and rules with trailing comments ...
+	ASSERT( test_registrable_domain( psl, "blogspot.com", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "me.blogspot.com", "me.blogspot.com" ) );
+	ASSERT( test_registrable_domain( psl, "github.io", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "a.b.github.io", "b.github.io" ) );
+
+	// ... trailing dot and invalid hosts ...
+	ASSERT( test_registrable_domain( psl, "www.example.com.", "example.com" ) );
+	ASSERT( test_registrable_domain( psl, "", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, ".", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, ".com", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, ".example.com", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "a..example.com", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "example..com", 0x0 ) );
+
+	return GREATEST_TEST_RES_PASS;
+}
+
+TEST psl_public_suffix()
+{
+	static char mem[4096];
+	const url_psl* psl = test_psl_build( mem, sizeof(mem) );
+	ASSERT( psl != 0x0 );
+
+	parsed_url_range range;
+	const char* host = "www.example.co.uk";
+	ASSERT( url_psl_public_suffix( psl, host, strlen( host ), &range ) );
+	ASSERT_EQ( 12u, range.offset );
+	ASSERT_EQ( 5u,  range.length );
+
+	// ... a host that is a public suffix is its own suffix ...
+	host = "co.uk";
+	ASSERT( url_psl_public_suffix( psl, host, strlen( host ), &range ) );
+	ASSERT_EQ( 0u, range.offset );
+	ASSERT_EQ( 5u, range.length );
+
+	host = "a.b.test.ck";
+	ASSERT( url_psl_public_suffix( psl, host, strlen( host ), &range ) );
+	ASSERT_EQ( 4u, range.offset );
+
+	host = "www.ck";
+	ASSERT( url_psl_public_suffix( psl, host, strlen( host ), &range ) );
+	ASSERT_EQ( 4u, range.offset );
+
+	ASSERT_FALSE( url_psl_public_suffix( psl, "", 0, &range ) );
+
+	return GREATEST_TEST_RES_PASS;
+}
+
+TEST psl_on_parsed_url()
+{
+	static char mem[4096];
+	const url_psl* psl = test_psl_build( mem, sizeof(mem) );
+	ASSERT( psl != 0x0 );
+
+	// ... hosts are lower-cased by parse_url() so can be used directly ...
+	char buffer[1024];
+	parsed_url* parsed = parse_url( "https://WWW.Example.CO.uk/path?q=1", buffer, sizeof(buffer) );
+	ASSERT( parsed != 0x0 );
+	ASSERT_EQ( (unsigned int)PARSE_URL_HOST_REG_NAME, parsed->host_type );
+
+	parsed_url_range range;
+	ASSERT( url_psl_registrable_domain( psl, parsed->host, strlen( parsed->host ), &range ) );
+	ASSERT_EQ( parsed->host + 4, parsed->host + range.offset );
+	ASSERT_EQ( 13u, range.length );
+
+	return GREATEST_TEST_RES_PASS;
+}
+
+TEST psl_build_fail()
+{
+	static char mem[4096];
+	size_t needed = url_psl_calc_mem_usage( test_psl_list, sizeof(test_psl_list) - 1 );
+	ASSERT( needed <= sizeof(mem) );
+
+	// ... out of memory, everything but the alignment slack is needed ...
+	for( size_t size = 0; size < needed - sizeof( void* ) * 4; ++size )
+		ASSERT_EQ( 0x0, url_psl_build( test_psl_list, sizeof(test_psl_list) - 1, mem, size ) );
+	ASSERT( url_psl_build( test_psl_list, sizeof(test_psl_list) - 1, mem, needed ) != 0x0 );
+
+	// ... an empty list only has the implicit "*" rule ...
+	const url_psl* psl = url_psl_build( "// nothing\n\n", 12, mem, url_psl_calc_mem_usage( "// nothing\n\n", 12 ) );
+	ASSERT( psl != 0x0 );
+	ASSERT( test_registrable_domain( psl, "com", 0x0 ) );
+	ASSERT( test_registrable_domain( psl, "a.b.com", "b.com" ) );
+
+	return GREATEST_TEST_RES_PASS;
+}
+
+static unsigned int test_psl_rand( unsigned int* state )
+{
+	*state = *state * 1103515245u + 12345u;
+	return ( *state >> 16 ) & 0x7FFF;
+}
+
+/**
+ * Number of labels in the public suffix of host, the slow way by testing all rules as described
+ * at https://publicsuffix.org/list/. If several exceptions match the shortest one wins, as it is
+ * found first when walking the labels from the right.
+ */
+static size_t test_psl_linear_suffix( const char* const* rules, size_t num_rules, const char* host )
+{
+	const char* host_labels[16];
+	size_t      num_host_labels = 0;
+	for( const char* l = host; l != 0x0; l = strchr( l, '.' ) ? strchr( l, '.' ) + 1 : 0x0 )
+		host_labels[num_host_labels++] = l;
+
+	size_t suffix           = 1;
+	size_t exception_suffix = (size_t)-1;
+	for( size_t r = 0; r < num_rules; ++r )
+	{
+		const char* rule      = rules[r];
+		bool        exception = rule[0] == '!';
+		if( exception )
+			++rule;
+
+		const char* rule_labels[16];
+		size_t      num_rule_labels = 0;
+		for( const char* l = rule; l != 0x0; l = strchr( l, '.' ) ? strchr( l, '.' ) + 1 : 0x0 )
+			rule_labels[num_rule_labels++] = l;
+		if( num_rule_labels > num_host_labels )
+			continue;
+
+		bool match = true;
+		for( size_t l = 0; match && l < num_rule_labels; ++l )
+		{
+			const char* rl = rule_labels[num_rule_labels - 1 - l];
+			const char* hl = host_labels[num_host_labels - 1 - l];
+			size_t rl_len = strcspn( rl, "." );
+			size_t hl_len = strcspn( hl, "." );
+			match = ( rl_len == 1 && rl[0] == '*' ) || ( rl_len == hl_len && memcmp( rl, hl, rl_len ) == 0 );
+		}
+		if( !match )
+			continue;
+		if( exception && num_rule_labels - 1 < exception_suffix )
+			exception_suffix = num_rule_labels - 1;
+		if( !exception && num_rule_labels > suffix )
+			suffix = num_rule_labels;
+	}
+	return exception_suffix != (size_t)-1 ? exception_suffix : suffix;
+}
+
+TEST psl_random()
+{
+	// ... the trie should agree with testing all rules, with lists and hosts built from a small set
+	//     of labels so that rules overlap a lot ...
+	static const char* const labels[] = { "a", "b", "c", "dd", "ee" };
+	static const size_t num_labels = sizeof(labels) / sizeof(labels[0]);
+
+	unsigned int state = 4711;
+	static char  mem[1 << 16];
+	char         list[4096];
+	char         rule_strs[64][32];
+	const char*  rules[64];
+
+	for( int iter = 0; iter < 200; ++iter )
+	{
+		list[0] = '\0';
+		size_t num_rules = test_psl_rand( &state ) % 64;
+		for( size_t r = 0; r < num_rules; ++r )
+		{
+			char* rule = rule_strs[r];
+			rule[0] = '\0';
+			unsigned int kind = test_psl_rand( &state ) % 6;
+			if( kind == 0 )
+				strcat( rule, "!" );
+			else if( kind == 1 )
+				strcat( rule, "*." );
+			size_t num_rule_labels = 1 + test_psl_rand( &state ) % 3;
+			for( size_t l = 0; l < num_rule_labels; ++l )
+			{
+				if( l > 0 )
+					strcat( rule, "." );
+				strcat( rule, labels[test_psl_rand( &state ) % num_labels] );
+			}
+			// ... exceptions are only valid below wildcards ...
+			if( kind == 0 && num_rule_labels == 1 )
+				strcat( rule, ".a" );
+
+			rules[r] = rule;
+			strcat( list, rule );
+			strcat( list, "\n" );
+		}
+
+		size_t list_len = strlen( list );
+		ASSERT( url_psl_calc_mem_usage( list, list_len ) <= sizeof(mem) );
+		const url_psl* psl = url_psl_build( list, list_len, mem, sizeof(mem) );
+		ASSERT( psl != 0x0 );
+
+		for( int t = 0; t < 100; ++t )
+		{
+			char host[64] = "";
+			size_t num_host_labels = 1 + test_psl_rand( &state ) % 5;
+			for( size_t l = 0; l < num_host_labels; ++l )
+			{
+				if( l > 0 )
+					strcat( host, "." );
+				strcat( host, labels[test_psl_rand( &state ) % num_labels] );
+			}
+
+			size_t expect = test_psl_linear_suffix( rules, num_rules, host );
+			parsed_url_range range;
+			ASSERT( url_psl_public_suffix( psl, host, strlen( host ), &range ) );
+
+			size_t got = 1;
+			for( size_t c = range.offset; c < strlen( host ); ++c )
+				got += host[c] == '.' ? 1 : 0;
+			if( got != expect )
+			{
+				printf( "host '%s' got %d labels, expected %d, list:\n%s", host, (int)got, (int)expect, list );
+				FAILm( "trie and linear match disagree" );
+			}
+		}
+	}
+
+	return GREATEST_TEST_RES_PASS;
+}
+
+GREATEST_SUITE( url_psl )
+{
+	RUN_TEST( psl_registrable_domain );
+	RUN_TEST( psl_public_suffix );
+	RUN_TEST( psl_on_parsed_url );
+	RUN_TEST( psl_build_fail );
+	RUN_TEST( psl_random );
+}
@@ -0,0 +1,321 @@
+/*
+    Simple router for paths of URL:s.
+
+    version 1.0, July, 2021
+
+	Copyright (C) 2021- Fredrik Kihlander
+
+	This software is provided 'as-is', without any express or implied
+	warranty.  In no event will the authors be held liable for any damages
+	arising from the use of this software.
+
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+
+	1. The origin of this software must not be misrepresented; you must not
+	   claim that you wrote the original software. If you use this software
+	   in a product, an acknowledgment in the product documentation would be
+	   appreciated but is not required.
+	2. Altered source versions must be plainly marked as such, and must not be
+	   misrepresented as being the original software.
+	3. This notice may not be removed or altered from any source distribution.
+
+	Fredrik Kihlander
+*/
+
+#define URL_ROUTER_IMPLEMENTATION
+
+#include "greatest.h"
+#include "../url_router.h"
+
+#include <stdio.h>
+
+static bool test_match( const url_router* router, const char* path, url_router_result* result )
+{
+	return url_router_match( router, path, strlen( path ), result );
+}
+
+static bool test_param_eq( const url_router_param& param, const char* name, const char* value )
+{
+	return param.name_len  == strlen( name )  && memcmp( param.name,  name,  param.name_len )  == 0 &&
+		   param.value_len == strlen( value ) && memcmp( param.value, value, param.value_len ) == 0;
+}
+
+TEST router_exact_and_params()
+{
+	const char* routes[] = {
+		"/",
+		"/api/v1/users",
+		"/api/v1/users/:id",
+		"/api/v1/users/:id/posts/:post",
+		"/api/v1/users/me",
+		"/api/v2/*rest",
+	};
+
+	static char mem[4096];
+	ASSERT( url_router_calc_mem_usage( routes, 6 ) <= sizeof(mem) );
+	const url_router* router = url_router_build( routes, 6, mem, sizeof(mem) );
+	ASSERT( router != 0x0 );
+
+	url_router_result res;
+	ASSERT( test_match( router, "/", &res ) );
+	ASSERT_EQ( 0u, res.route );
+	ASSERT( test_match( router, "", &res ) );
+	ASSERT_EQ( 0u, res.route );
+
+	ASSERT( test_match( router, "/api/v1/users", &res ) );
+	ASSERT_EQ( 1u, res.route );
+	ASSERT_EQ( 0u, res.num_params );
+
+	// ... empty segments are ignored, as by parse_url_path_next() ...
+	ASSERT( test_match( router, "//api/v1//users/", &res ) );
+	ASSERT_EQ( 1u, res.route );
+
+	ASSERT( test_match( router, "/api/v1/users/1234", &res ) );
+	ASSERT_EQ( 2u, res.route );
+	ASSERT_EQ( 1u, res.num_params );
+	ASSERT( test_param_eq( res.params[0], "id", "1234" ) );
+
+	// ... exact segment before parameter ...
+	ASSERT( test_match( router, "/api/v1/users/me", &res ) );
+	ASSERT_EQ( 4u, res.route );
+	ASSERT_EQ( 0u, res.num_params );
+
+	// ... but a parameter if the exact segment leads nowhere ...
+	ASSERT( test_match( router, "/api/v1/users/me/posts/p1", &res ) );
+	ASSERT_EQ( 3u, res.route );
+	ASSERT_EQ( 2u, res.num_params );
+	ASSERT( test_param_eq( res.params[0], "id", "me" ) );
+	ASSERT( test_param_eq( res.params[1], "post", "p1" ) );
+
+	// ... values point into the path ...
+	const char* path = "/api/v2/some/file.txt";
+	ASSERT( test_match( router, path, &res ) );
+	ASSERT_EQ( 5u, res.route );
+	ASSERT_EQ( 1u, res.num_params );
+	ASSERT_EQ( path + 8, res.params[0].value );
+	ASSERT( test_param_eq( res.params[0], "rest", "some/file.txt" ) );
+
+	ASSERT( test_match( router, "/api/v2", &res ) );
+	ASSERT_EQ( 5u, res.route );
+	ASSERT_EQ( 0u, res.params[0].value_len );
+
+	ASSERT_FALSE( test_match( router, "/api", &res ) );
+	ASSERT_FALSE( test_match( router, "/api/v3/users", &res ) );
+	ASSERT_FALSE( test_match( router, "/api/v1/users/1/posts", &res ) );
+	ASSERT_FALSE( test_match( router, "/api/v1/users/1/posts/2/3", &res ) );
+
+	return GREATEST_TEST_RES_PASS;
+}
+
+TEST router_first_route_wins()
+{
+	const char* routes[] = {
+		"/a/:x",
+		"/a/:y",
+		"/b/*",
+		"/b/*rest",
+		"/a/:z/c",
+	};
+
+	static char mem[4096];
+	const url_router* router = url_router_build( routes, 5, mem, sizeof(mem) );
+	ASSERT( router != 0x0 );
+
+	url_router_result res;
+	ASSERT( test_match( router, "/a/1", &res ) );
+	ASSERT_EQ( 0u, res.route );
+	ASSERT( test_param_eq( res.params[0], "x", "1" ) );
+
+	// ... parameter names are per route even if they share the node ...
+	ASSERT( test_match( router, "/a/1/c", &res ) );
+	ASSERT_EQ( 4u, res.route );
+	ASSERT( test_param_eq( res.params[0], "z", "1" ) );
+
+	ASSERT( test_match( router, "/b/x/y", &res ) );
+	ASSERT_EQ( 2u, res.route );
+	ASSERT( test_param_eq( res.params[0], "", "x/y" ) );
+
+	return GREATEST_TEST_RES_PASS;
+}
+
+TEST router_on_parsed_url()
+{
+	const char* routes[] = { "/users/:name/files/*path" };
+
+	static char mem[1024];
+	const url_router* router = url_router_build( routes, 1, mem, sizeof(mem) );
+	ASSERT( router != 0x0 );
+
+	char buffer[1024];
+	parsed_url* parsed = parse_url( "http://testurl.com/users/fredrik/files/a/b%20c.txt?x=1", buffer, sizeof(buffer) );
+	ASSERT( parsed != 0x0 );
+
+	url_router_result res;
+	ASSERT( url_router_match( router, parsed->path, strlen( parsed->path ), &res ) );
+	ASSERT_EQ( 2u, res.num_params );
+	ASSERT( test_param_eq( res.params[0], "name", "fredrik" ) );
+	ASSERT( test_param_eq( res.params[1], "path", "a/b c.txt" ) );
+
+	return GREATEST_TEST_RES_PASS;
+}
+
+TEST router_build_fail()
+{
+	static char mem[4096];
+
+	// ... '*' has to be last ...
+	const char* wildcard_not_last[] = { "/a/*rest/b" };
+	ASSERT_EQ( 0x0, url_router_build( wildcard_not_last, 1, mem, sizeof(mem) ) );
+
+	// ... to many parameters ...
+	char many[URL_ROUTER_MAX_PARAMS * 4 + 8] = "";
+	for( int i = 0; i <= URL_ROUTER_MAX_PARAMS; ++i )
+		strcat( many, "/:p" );
+	const char* too_many[] = { many };
+	ASSERT_EQ( 0x0, url_router_build( too_many, 1, mem, sizeof(mem) ) );
+	many[strlen( many ) - 3] = '\0';
+	ASSERT( url_router_build( too_many, 1, mem, sizeof(mem) ) != 0x0 );
+
+	// ... out of memory, at every size ...
+	const char* routes[] = { "/a/b", "/a/:c/d", "/e/*f", "/" };
+	size_t needed = url_router_calc_mem_usage( routes, 4 );
+	for( size_t size = 0; size < needed - sizeof( void* ) * 6; ++size )
+		ASSERT_EQ( 0x0, url_router_build( routes, 4, mem, size ) );
+	ASSERT( url_router_build( routes, 4, mem, needed ) != 0x0 );
+
+	// ... no routes at all ...
+	ASSERT( url_router_build( routes, 0, mem, url_router_calc_mem_usage( routes, 0 ) ) != 0x0 );
+
+	return GREATEST_TEST_RES_PASS;
+}
+
+static unsigned int test_router_rand( unsigned int* state )
+{
+	*state = *state * 1103515245u + 12345u;
+	return ( *state >> 16 ) & 0x7FFF;
+}
+
+/**
+ * Match path against route the slow way, returns false if it does not match or the kind of each
+ * segment, 1 = exact, 2 = parameter and 3 = rest, as kinds for comparing what route is best.
+ */
+static bool test_router_linear_match( const char* route, const char* path, int* kinds, size_t* num_kinds )
+{
+	parse_url_path_iter route_it;
+	parse_url_path_iter path_it;
+	parse_url_path_iter_init( &route_it, route, strlen( route ) );
+	parse_url_path_iter_init( &path_it, path, strlen( path ) );
+	*num_kinds = 0;
+
+	parsed_url_path_segment r;
+	parsed_url_path_segment p;
+	while( parse_url_path_next( &route_it, &r ) )
+	{
+		if( r.str[0] == '*' )
+		{
+			kinds[(*num_kinds)++] = 3;
+			return true;
+		}
+		if( !parse_url_path_next( &path_it, &p ) )
+			return false;
+		if( r.str[0] == ':' )
+			kinds[(*num_kinds)++] = 2;
+		else if( r.len == p.len && memcmp( r.str, p.str, r.len ) == 0 )
+			kinds[(*num_kinds)++] = 1;
+		else
+			return false;
+	}
+	return !parse_url_path_next( &path_it, &p );
+}
+
+TEST router_random()
+{
+	// ... the router should pick the same route as trying all routes and pick the best, where best is
+	//     the one with the lowest segment kinds from the start of the path ...
+	static const char* const route_parts[] = { "/a", "/b", "/c", "/:p", "/:q", "/*r", "/" };
+	static const char* const path_parts[]  = { "/a", "/b", "/c", "/d", "/" };
+
+	unsigned int state = 1337;
+	static char  mem[1 << 16];
+	char         route_strs[64][64];
+	const char*  routes[64];
+
+	for( int iter = 0; iter < 200; ++iter )
+	{
+		size_t num_routes = 1 + test_router_rand( &state ) % 64;
+		for( size_t r = 0; r < num_routes; ++r )
+		{
+			route_strs[r][0] = '\0';
+			size_t num_parts = test_router_rand( &state ) % 5;
+			for( size_t p = 0; p < num_parts; ++p )
+			{
+				const char* part = route_parts[test_router_rand( &state ) % ( sizeof(route_parts) / sizeof(route_parts[0]) )];
+				strcat( route_strs[r], part );
+				if( part[1] == '*' )
+					break;
+			}
+			routes[r] = route_strs[r];
+		}
+
+		const url_router* router = url_router_build( routes, num_routes, mem, sizeof(mem) );
+		ASSERT( router != 0x0 );
+
+		for( int t = 0; t < 100; ++t )
+		{
+			char path[64] = "";
+			size_t num_parts = test_router_rand( &state ) % 6;
+			for( size_t p = 0; p < num_parts; ++p )
+				strcat( path, path_parts[test_router_rand( &state ) % ( sizeof(path_parts) / sizeof(path_parts[0]) )] );
+
+			size_t best = (size_t)-1;
+			int    best_kinds[8];
+			size_t best_num_kinds = 0;
+			for( size_t r = 0; r < num_routes; ++r )
+			{
+				int    kinds[8];
+				size_t num_kinds;
+				if( !test_router_linear_match( routes[r], path, kinds, &num_kinds ) )
+					continue;
+
+				bool better = best == (size_t)-1;
+				for( size_t k = 0; !better && k < num_kinds && k < best_num_kinds; ++k )
+				{
+					if( kinds[k] != best_kinds[k] )
+					{
+						better = kinds[k] < best_kinds[k];
+						break;
+					}
+				}
+				if( !better && best != (size_t)-1 && num_kinds < best_num_kinds && memcmp( kinds, best_kinds, sizeof(int) * num_kinds ) == 0 )
+					better = true;
+				if( better )
+				{
+					best = r;
+					best_num_kinds = num_kinds;
+					memcpy( best_kinds, kinds, sizeof(int) * num_kinds );
+				}
+			}
+
+			url_router_result res;
+			bool matched = url_router_match( router, path, strlen( path ), &res );
+			if( matched != ( best != (size_t)-1 ) || ( matched && res.route != best ) )
+			{
+				printf( "path '%s' matched %d, expected %d\n", path, matched ? (int)res.route : -1, (int)best );
+				FAILm( "router and linear match disagree" );
+			}
+		}
+	}
+
+	return GREATEST_TEST_RES_PASS;
+}
+
+GREATEST_SUITE( url_router )
+{
+	RUN_TEST( router_exact_and_params );
+	RUN_TEST( router_first_route_wins );
+	RUN_TEST( router_on_parsed_url );
+	RUN_TEST( router_build_fail );
+	RUN_TEST( router_random );
+}
@@ -3,6 +3,8 @@
 
  compile with URL_PARSER_IMPLEMENTATION defined for implementation.
  compile with URL_PARSER_IMPLEMENTATION_STATIC defined for static implementation.
+ compile with URL_PARSER_MALLOC(size) and URL_PARSER_FREE(ptr) defined to replace malloc/free, urls parsed
+ with mem == NULL will then need to be free:ed with URL_PARSER_FREE().
 
  version 1.0, June, 2014
 
@@ -31,6 +33,7 @@
 #define URL_H_INCLUDED
 
 #include <stdlib.h>
+#include <stdint.h>
 
 #if defined(URL_PARSER_IMPLEMENTATION_STATIC)
 #  if !defined(URL_PARSER_IMPLEMENTATION)
@@ -41,6 +44,89 @@
 #    define URL_PARSER_LINKAGE
 #endif
 
+/**
+ * Id of the scheme of a parsed url, stored in parsed_url::scheme_id and parsed_url_view::scheme_id
+ * so that users can switch on the scheme without comparing strings again. The comment on each
+ * builtin scheme is the default port used when the url has no explicit port.
+ */
+enum parse_url_scheme_id
+{
+	PARSE_URL_SCHEME_NONE = 0,    // url has no scheme.
+	PARSE_URL_SCHEME_UNKNOWN,     // url has a scheme that is neither builtin nor registered, port defaults to 0.
+	PARSE_URL_SCHEME_HTTP,       // "http"         - 80
+	PARSE_URL_SCHEME_HTTPS,      // "https"        - 443
+	PARSE_URL_SCHEME_FTP,        // "ftp"          - 21
+	PARSE_URL_SCHEME_SSH,        // "ssh"          - 22
+	PARSE_URL_SCHEME_TELNET,     // "telnet"       - 23
+	PARSE_URL_SCHEME_WS,         // "ws"           - 80
+	PARSE_URL_SCHEME_WSS,        // "wss"          - 443
+	PARSE_URL_SCHEME_FILE,       // "file"         - 0
+	PARSE_URL_SCHEME_SFTP,       // "sftp"         - 22
+	PARSE_URL_SCHEME_FTPS,       // "ftps"         - 990
+	PARSE_URL_SCHEME_GIT,        // "git"          - 9418
+	PARSE_URL_SCHEME_LDAP,       // "ldap"         - 389
+	PARSE_URL_SCHEME_LDAPS,      // "ldaps"        - 636
+	PARSE_URL_SCHEME_SMTP,       // "smtp"         - 25
+	PARSE_URL_SCHEME_IMAP,       // "imap"         - 143
+	PARSE_URL_SCHEME_IMAPS,      // "imaps"        - 993
+	PARSE_URL_SCHEME_POP3,       // "pop3"         - 110
+	PARSE_URL_SCHEME_POP3S,      // "pop3s"        - 995
+	PARSE_URL_SCHEME_NNTP,       // "nntp"         - 119
+	PARSE_URL_SCHEME_GOPHER,     // "gopher"       - 70
+	PARSE_URL_SCHEME_RTSP,       // "rtsp"         - 554
+	PARSE_URL_SCHEME_SIP,        // "sip"          - 5060
+	PARSE_URL_SCHEME_SIPS,       // "sips"         - 5061
+	PARSE_URL_SCHEME_REDIS,      // "redis"        - 6379
+	PARSE_URL_SCHEME_REDISS,     // "rediss"       - 6379
+	PARSE_URL_SCHEME_POSTGRES,   // "postgres"     - 5432
+	PARSE_URL_SCHEME_POSTGRESQL, // "postgresql"   - 5432
+	PARSE_URL_SCHEME_MYSQL,      // "mysql"        - 3306
+	PARSE_URL_SCHEME_MONGODB,    // "mongodb"      - 27017
+	PARSE_URL_SCHEME_AMQP,       // "amqp"         - 5672
+	PARSE_URL_SCHEME_AMQPS,      // "amqps"        - 5671
+	PARSE_URL_SCHEME_MQTT,       // "mqtt"         - 1883
+	PARSE_URL_SCHEME_MQTTS,      // "mqtts"        - 8883
+
+	/**
+	 * schemes registered with parse_url_set_scheme_table() get ids from PARSE_URL_SCHEME_USER_FIRST
+	 * and up, in the order they was passed to parse_url_scheme_table_build().
+	 */
+	PARSE_URL_SCHEME_USER_FIRST = 256
+};
+
+/**
+ * Type of the host of a parsed url, stored in parsed_url::host_type and parsed_url_view::host_type.
+ */
+enum parse_url_host_type
+{
+	PARSE_URL_HOST_NONE = 0, // url has no host, parsed_url::host will be "localhost".
+	PARSE_URL_HOST_REG_NAME, // host is a name, such as "testurl.com".
+	PARSE_URL_HOST_IPV4,     // host is an ipv4 address in dotted-decimal form, decoded to ipv4.
+	PARSE_URL_HOST_IPV6      // host is an ipv6 address in [], decoded to ipv6.
+};
+
+/**
+ * One parameter of a query-string, such as "key=value" in "?key=value&other".
+ * key and value point into the query-string and are neither '\0'-terminated nor decoded,
+ * use parse_url_query_decode() to get the decoded strings.
+ */
+struct parsed_url_query_param
+{
+	const char* key;
+	size_t      key_len;
+
+	/**
+	 * value of parameter or 0x0 if the parameter had no '=', as "other" above.
+	 */
+	const char* value;
+	size_t      value_len;
+};
+
+/**
+ * Hash-index over query-parameters for lookup of parameters by key, see parse_url_query_index_build().
+ */
+struct parse_url_query_index;
+
 /**
  * Struct describing a parsed url.
  *
@@ -50,7 +136,8 @@ struct parsed_url
 {
 	/**
 	 * scheme part of url or 0x0 if not present.
-	 * @note the scheme will be lower-cased!
+	 * @note the scheme will be lower-cased! Only ascii 'A'-'Z' is lower-cased so the result
+	 *       does not depend on the current locale, see setlocale().
 	 */
 	const char*  scheme;
 
@@ -71,36 +158,64 @@ struct parsed_url
 	 * It will also be verified that it is a valid ipv6 address, parsing
 	 * will have failed if anything that is not an ipv6 address was found
 	 * within a []
-	 * @note the scheme will be lower-cased!
+	 * @note the host will be lower-cased! Only ascii 'A'-'Z' is lower-cased so the result
+	 *       does not depend on the current locale, see setlocale().
 	 */
 	const char*  host;
 
+	/**
+	 * type of host, one of parse_url_host_type.
+	 */
+	unsigned int host_type;
+
+	/**
+	 * ipv4 address of host if host_type is PARSE_URL_HOST_IPV4, in host byte-order, i.e.
+	 * 192.168.0.1 is 0xC0A80001. 0 otherwise.
+	 */
+	uint32_t     ipv4;
+
+	/**
+	 * ipv6 address of host if host_type is PARSE_URL_HOST_IPV6, in network byte-order as
+	 * filled by inet_pton(). All 0 otherwise.
+	 */
+	uint8_t      ipv6[16];
+
 	/**
 	 * port part of url.
 	 * if not present a default depending on scheme is used, if no default is
-	 * available for scheme, 0 will be used.
+	 * available for scheme, 0 will be used. PARSED_URL_PORT_EXPLICIT is set in flags
+	 * if the port was given in the url. Ports that are not a number in 0-65535 fails the parse.
 	 *
-	 * supported defaults:
+	 * supported defaults, see parse_url_scheme_id for the full list:
 	 * "http"   - 80
 	 * "https"  - 443
 	 * "ftp"    - 21
 	 * "ssh"    - 22
 	 * "telnet" - 23
+	 * "ws"     - 80
+	 * "wss"    - 443
 	 */
 	unsigned int port;
 
+	/**
+	 * id of scheme, one of parse_url_scheme_id.
+	 */
+	unsigned int scheme_id;
+
 	/**
 	 * path part of url.
 	 * if the path part of the url is not present, it will default to "/"
 	 * @note percent-encoded values will get decoded during parse, i.e. %21 will be translated
-	 *       to '!' etc.
+	 *       to '!' etc. If parsed with PARSE_URL_FLAG_LAZY_DECODE the path is left encoded,
+	 *       PARSED_URL_PATH_ENCODED is set in flags and parse_url_decode_path() decodes it.
 	 *       see: https://en.wikipedia.org/wiki/Percent-encoding
 	 */
 	const char*  path;
 
 	/**
 	 * query part of url, default to 0x0 if not present in url.
-	 * as this is not standardized it is not parsed for the user.
+	 * as this is not standardized it is not parsed for the user, but parse_url_query_next() and
+	 * parse_url_query_split() can split it in key/value-pairs as "key=value&key2=value2".
 	 */
 	 const char*  query;
 
@@ -108,13 +223,171 @@ struct parsed_url
 	 * fragment part of url, default to 0x0 if not present in url.
 	 */
 	 const char*  fragment;
+
+	/**
+	 * combination of parsed_url_flags.
+	 */
+	unsigned int flags;
+
+	/**
+	 * parameters of query if parsed with PARSE_URL_FLAG_QUERY_PARAMS, all pointing into query.
+	 * 0x0 and 0 otherwise.
+	 */
+	const parsed_url_query_param* query_params;
+	size_t                        num_query_params;
+
+	/**
+	 * index of query_params if parsed with PARSE_URL_FLAG_QUERY_INDEX, 0x0 otherwise.
+	 * see parse_url_get_param().
+	 */
+	const parse_url_query_index* query_index;
+};
+
+/**
+ * Flags set in parsed_url::flags.
+ */
+enum parsed_url_flags
+{
+	PARSED_URL_PATH_ENCODED = 1 << 0, // path still contains percent-encoded values, see parse_url_decode_path().
+	PARSED_URL_PORT_EXPLICIT = 1 << 1  // port was given in the url and not the default port of the scheme.
+};
+
+/**
+ * Flags that can be passed to parse_url() and parse_url_n().
+ */
+enum parse_url_flags
+{
+	/**
+	 * Do not decode the path while parsing, leave that to parse_url_decode_path() for the
+	 * users that need the decoded path. The path is still validated.
+	 */
+	PARSE_URL_FLAG_LAZY_DECODE = 1 << 0,
+
+	/**
+	 * Split the query in parameters and store them in parsed_url::query_params, in the same
+	 * memory as the rest of the parsed url.
+	 */
+	PARSE_URL_FLAG_QUERY_PARAMS = 1 << 1,
+
+	/**
+	 * Same as PARSE_URL_FLAG_QUERY_PARAMS but also build a parse_url_query_index over the parameters
+	 * in parsed_url::query_index, for urls where many parameters are looked up by key.
+	 */
+	PARSE_URL_FLAG_QUERY_INDEX = 1 << 2,
+
+	/**
+	 * Normalize the path as parse_url_normalize_path() with PARSE_URL_NORMALIZE_DOT_SEGMENTS, and
+	 * PARSE_URL_NORMALIZE_ESCAPES if the path is not decoded, see PARSE_URL_FLAG_LAZY_DECODE.
+	 */
+	PARSE_URL_FLAG_NORMALIZE_PATH = 1 << 3,
+
+	/**
+	 * Collapse repeated '/' in the path, as parse_url_normalize_path() with PARSE_URL_NORMALIZE_COLLAPSE_SLASHES.
+	 */
+	PARSE_URL_FLAG_COLLAPSE_SLASHES = 1 << 4
+};
+
+/**
+ * Flags that can be passed to parse_url_normalize_path().
+ */
+enum parse_url_normalize_flags
+{
+	PARSE_URL_NORMALIZE_DOT_SEGMENTS     = 1 << 0, // remove "." and ".." segments as specified by RFC3986 5.2.4.
+	PARSE_URL_NORMALIZE_COLLAPSE_SLASHES = 1 << 1, // replace repeated '/' with a single one, "/a//b" -> "/a/b".
+	PARSE_URL_NORMALIZE_ESCAPES          = 1 << 2  // decode %xx of unreserved chars and upper-case the hex-digits of the rest, "%7e%2f" -> "~%2F".
+};
+
+/**
+ * Offset and length of one component of an url, relative to the start of the
+ * string that was parsed.
+ */
+struct parsed_url_range
+{
+	size_t offset;
+	size_t length;
+};
+
+/**
+ * Flags set in parsed_url_view::flags for the components present in the url.
+ */
+enum parsed_url_view_flags
+{
+	PARSED_URL_VIEW_HAS_SCHEME   = 1 << 0,
+	PARSED_URL_VIEW_HAS_USER     = 1 << 1,
+	PARSED_URL_VIEW_HAS_PASS     = 1 << 2,
+	PARSED_URL_VIEW_HAS_HOST     = 1 << 3,
+	PARSED_URL_VIEW_HAS_PATH     = 1 << 4,
+	PARSED_URL_VIEW_HAS_QUERY    = 1 << 5,
+	PARSED_URL_VIEW_HAS_FRAGMENT = 1 << 6,
+	PARSED_URL_VIEW_PATH_ENCODED = 1 << 7, // path contains at least one '%' and need to be decoded.
+	PARSED_URL_VIEW_HAS_PORT     = 1 << 8  // port was given in the url, same as PARSED_URL_PORT_EXPLICIT.
+};
+
+/**
+ * Zero-copy version of parsed_url, filled by parse_url_view().
+ *
+ * All components are ranges into the parsed string and are only valid if the
+ * corresponding PARSED_URL_VIEW_HAS_* flag is set. Nothing is lower-cased or
+ * percent-decoded, use parse_url_view_copy_lower() and parse_url_view_decode() to
+ * get the same strings as parse_url() would return. The path only need to be
+ * decoded if PARSED_URL_VIEW_PATH_ENCODED is set.
+ *
+ * @note a host in [] is returned without the [].
+ */
+struct parsed_url_view
+{
+	/**
+	 * the string that was parsed, all ranges are relative to this.
+	 */
+	const char* url;
+
+	/**
+	 * combination of parsed_url_view_flags.
+	 */
+	unsigned int flags;
+
+	/**
+	 * port of url, explicit or default for scheme, same as parsed_url::port.
+	 */
+	unsigned int port;
+
+	/**
+	 * id of scheme, same as parsed_url::scheme_id.
+	 */
+	unsigned int scheme_id;
+
+	/**
+	 * type of host and decoded address, same as parsed_url::host_type, parsed_url::ipv4 and parsed_url::ipv6.
+	 */
+	unsigned int host_type;
+	uint32_t     ipv4;
+	uint8_t      ipv6[16];
+
+	parsed_url_range scheme;
+	parsed_url_range user;
+	parsed_url_range pass;
+	parsed_url_range host;
+	parsed_url_range path;
+	parsed_url_range query;
+	parsed_url_range fragment;
 };
 
 /**
  * Calculate the amount of memory needed to parse the specified url.
+ * This is an upper bound found without parsing the url, see parse_url_view_calc_mem_usage() for
+ * the exact amount.
  * @param url the url to parse.
+ * @param flags combination of parse_url_flags that will be passed to parse_url().
+ */
+URL_PARSER_LINKAGE size_t parse_url_calc_mem_usage(const char* url, unsigned int flags = 0);
+
+/**
+ * Calculate the amount of memory needed to parse the specified url with parse_url_n().
+ * @param url the url to parse, does not need to be '\0'-terminated.
+ * @param url_len length of url in bytes.
+ * @param flags combination of parse_url_flags that will be passed to parse_url_n().
  */
-URL_PARSER_LINKAGE size_t parse_url_calc_mem_usage(const char* url);
+URL_PARSER_LINKAGE size_t parse_url_calc_mem_usage_n(const char* url, size_t url_len, unsigned int flags = 0);
 
 /**
  * Parse an url specified by RFC1738 into its parts.
@@ -122,345 +395,3268 @@ URL_PARSER_LINKAGE size_t parse_url_calc_mem_usage(const char* url);
  * @param url url to parse.
  * @param mem memory-buffer to use to parse the url or NULL to use malloc.
  * @param mem_size size of mem in bytes.
+ * @param flags combination of parse_url_flags.
+ *
+ * @return parsed url. If mem is NULL this value will need to be free:ed with free().
+ */
+URL_PARSER_LINKAGE parsed_url* parse_url(const char* url, void* mem, size_t mem_size, unsigned int flags = 0);
+
+/**
+ * Same as parse_url() but parse the first url_len bytes of url, url does not need to be
+ * '\0'-terminated and no byte after url_len will be read. Useful when parsing directly from
+ * network buffers or memory-mapped files.
+ *
+ * @param url url to parse.
+ * @param url_len length of url in bytes.
+ * @param mem memory-buffer to use to parse the url or NULL to use malloc.
+ * @param mem_size size of mem in bytes.
+ * @param flags combination of parse_url_flags.
  *
  * @return parsed url. If mem is NULL this value will need to be free:ed with free().
  */
-URL_PARSER_LINKAGE parsed_url* parse_url(const char* url, void* mem, size_t mem_size);
+URL_PARSER_LINKAGE parsed_url* parse_url_n(const char* url, size_t url_len, void* mem, size_t mem_size, unsigned int flags = 0);
+
+/**
+ * Fixed-capacity memory for parse_url() for parsing on the stack or in other objects without any
+ * heap-allocations. Urls that do not fit in N bytes fail to parse and parse() returns NULL.
+ *
+ * N = sizeof(parsed_url) + max_url_len + 7 fits all urls up to max_url_len bytes parsed without
+ * PARSE_URL_FLAG_QUERY_PARAMS or PARSE_URL_FLAG_QUERY_INDEX.
+ *
+ * @example
+ * parse_url_buffer<512> buffer;
+ * parsed_url* parsed = buffer.parse( url );
+ */
+template <size_t N>
+struct parse_url_buffer
+{
+	// ... fail at compile time for buffers that can never fit a parsed_url ...
+	typedef char buffer_smaller_than_parsed_url[N >= sizeof( parsed_url ) ? 1 : -1];
+
+	/**
+	 * the memory, aligned for the parsed_url placed first in it.
+	 */
+	union
+	{
+		char  mem[N];
+		void* align;
+	};
+
+	/**
+	 * Parse url into the buffer, replacing any url previously parsed with it.
+	 * @return parsed url or NULL if it is invalid or does not fit in N bytes.
+	 */
+	parsed_url* parse(const char* url, unsigned int flags = 0) { return parse_url( url, mem, N, flags ); }
+
+	/**
+	 * Same as parse() but as parse_url_n().
+	 */
+	parsed_url* parse_n(const char* url, size_t url_len, unsigned int flags = 0) { return parse_url_n( url, url_len, mem, N, flags ); }
+};
+
+/**
+ * Percent-decode the path of an url parsed with PARSE_URL_FLAG_LAZY_DECODE in place. Does
+ * nothing if PARSED_URL_PATH_ENCODED is not set, i.e. if the path had no '%' or is already decoded.
+ *
+ * @param parsed url to decode path of, must not be a url parsed to read-only memory.
+ *
+ * @return the decoded path.
+ */
+URL_PARSER_LINKAGE const char* parse_url_decode_path(parsed_url* parsed);
+
+/**
+ * Normalize the first path_len chars of path in place in one pass, the result is never longer
+ * than the input.
+ *
+ * @note PARSE_URL_NORMALIZE_ESCAPES should only be used on paths that is still percent-encoded.
+ *
+ * @param path path to normalize.
+ * @param path_len length of path in bytes.
+ * @param flags combination of parse_url_normalize_flags.
+ *
+ * @return the length of the normalized path, path is not '\0'-terminated.
+ */
+URL_PARSER_LINKAGE size_t parse_url_normalize_path(char* path, size_t path_len, unsigned int flags);
+
+/**
+ * Normalize the path of parsed in place with parse_url_normalize_path(). PARSE_URL_NORMALIZE_ESCAPES
+ * is ignored if PARSED_URL_PATH_ENCODED is not set, i.e. the path is already decoded.
+ *
+ * @param parsed url to normalize path of, must not be a url parsed to read-only memory.
+ * @param flags combination of parse_url_normalize_flags.
+ *
+ * @return the normalized path.
+ */
+URL_PARSER_LINKAGE const char* parse_url_normalize(parsed_url* parsed, unsigned int flags);
+
+/**
+ * One segment of a path, such as "b" in "/a/b/c". Points into the path and is neither
+ * '\0'-terminated nor decoded.
+ */
+struct parsed_url_path_segment
+{
+	const char* str;
+	size_t      len;
+};
+
+/**
+ * Iterator over the segments of a path, initialize with parse_url_path_iter_init() and step
+ * with parse_url_path_next().
+ */
+struct parse_url_path_iter
+{
+	const char* pos;
+	const char* end;
+};
+
+/**
+ * Initialize it to iterate over the segments in path.
+ *
+ * @param it iterator to initialize.
+ * @param path path to iterate, such as parsed_url::path. Can be 0x0.
+ * @param path_len length of path in bytes.
+ */
+URL_PARSER_LINKAGE void parse_url_path_iter_init(parse_url_path_iter* it, const char* path, size_t path_len);
+
+/**
+ * Get the next segment from it. Segments are separated by '/', empty segments such as in
+ * "/a//b/" are skipped. The path is not copied or modified.
+ *
+ * @param it iterator to step.
+ * @param segment segment to fill.
+ *
+ * @return false when there are no more segments.
+ */
+URL_PARSER_LINKAGE bool parse_url_path_next(parse_url_path_iter* it, parsed_url_path_segment* segment);
+
+/**
+ * Split path into segments, same as calling parse_url_path_next() until it returns false.
+ *
+ * @param path path to split. Can be 0x0.
+ * @param path_len length of path in bytes.
+ * @param segments array to fill with at most max_segments segments, can be 0x0 if max_segments is 0.
+ * @param max_segments size of segments.
+ *
+ * @return number of segments in path, this might be more than max_segments.
+ */
+URL_PARSER_LINKAGE size_t parse_url_path_split(const char* path, size_t path_len, parsed_url_path_segment* segments, size_t max_segments);
+
+/**
+ * Calculate the amount of memory needed to resolve ref against base with parse_url_resolve().
+ * @param base url to resolve against.
+ * @param ref reference to resolve.
+ */
+URL_PARSER_LINKAGE size_t parse_url_resolve_calc_mem_usage(const parsed_url* base, const char* ref);
+
+/**
+ * Same as parse_url_resolve_calc_mem_usage() but for a ref of ref_len bytes that does not need to be '\0'-terminated.
+ */
+URL_PARSER_LINKAGE size_t parse_url_resolve_calc_mem_usage_n(const parsed_url* base, const char* ref, size_t ref_len);
+
+/**
+ * Resolve the reference ref against base as specified by RFC3986 5.2, i.e. find the url that a
+ * link, ref, on the page base points to. Only ref is parsed, the components of base are reused
+ * as they are. Dot-segments, "." and "..", are removed from the resulting path.
+ *
+ * @note the path of base is used as stored in base, decoded unless base was parsed with
+ *       PARSE_URL_FLAG_LAZY_DECODE. The path of the result is decoded the same way, also when
+ *       the path of ref replaces the path of base, so parse_url_decode_path() can be used on
+ *       any url resolved against a lazy decoded base.
+ *
+ * @param base url to resolve against.
+ * @param ref reference to resolve, an url, "//host/path", "/path", "path", "?query" or "#fragment".
+ * @param mem memory-buffer to store the result in or NULL to use malloc.
+ * @param mem_size size of mem in bytes.
+ *
+ * @return resolved url or NULL if ref is invalid or mem is too small. If mem is NULL this value
+ *         will need to be free:ed with free().
+ */
+URL_PARSER_LINKAGE parsed_url* parse_url_resolve(const parsed_url* base, const char* ref, void* mem, size_t mem_size);
+
+/**
+ * Same as parse_url_resolve() but resolve the first ref_len bytes of ref, ref does not need to be '\0'-terminated.
+ */
+URL_PARSER_LINKAGE parsed_url* parse_url_resolve_n(const parsed_url* base, const char* ref, size_t ref_len, void* mem, size_t mem_size);
+
+/**
+ * One component of a parsed_url_packed, offset is relative to the start of the parsed_url_packed
+ * and 0 if the component is not present.
+ */
+struct parsed_url_packed_range
+{
+	uint32_t offset;
+	uint32_t length;
+};
+
+/**
+ * Relocatable version of parsed_url, created by parse_url_pack().
+ *
+ * The header is followed by the '\0'-terminated strings of all components in the same block of
+ * memory and there are no pointers, so a parsed_url_packed can be memcpy:ed, written to disk or
+ * placed in shared memory and used as is from there, see parse_url_packed_check().
+ *
+ * @note values are stored in the byte-order of the machine packing them.
+ * @note query_params and query_index of parsed_url are not packed, use parse_url_query_split()
+ *       on the query.
+ */
+struct parsed_url_packed
+{
+	/**
+	 * size of header and strings in bytes.
+	 */
+	uint32_t size;
+
+	/**
+	 * same as the members of parsed_url with the same names.
+	 */
+	uint32_t flags;
+	uint32_t port;
+	uint32_t scheme_id;
+	uint32_t host_type;
+	uint32_t ipv4;
+	uint8_t  ipv6[16];
+
+	/**
+	 * components of the url, get the strings with parsed_url_packed_str().
+	 */
+	parsed_url_packed_range scheme;
+	parsed_url_packed_range user;
+	parsed_url_packed_range pass;
+	parsed_url_packed_range host;
+	parsed_url_packed_range path;
+	parsed_url_packed_range query;
+	parsed_url_packed_range fragment;
+};
+
+/**
+ * Get the '\0'-terminated string of one component of packed, such as parsed_url_packed_str( packed, packed->host ).
+ *
+ * @return the string or 0x0 if the component is not present, the same as the member of parsed_url.
+ */
+inline const char* parsed_url_packed_str(const parsed_url_packed* packed, parsed_url_packed_range range)
+{
+	return range.offset == 0 ? 0x0 : (const char*)packed + range.offset;
+}
+
+/**
+ * Calculate the amount of memory needed to pack parsed with parse_url_pack(), this is also the
+ * final parsed_url_packed::size.
+ */
+URL_PARSER_LINKAGE size_t parse_url_pack_calc_mem_usage(const parsed_url* parsed);
+
+/**
+ * Convert parsed to a parsed_url_packed.
+ *
+ * @param parsed url to pack.
+ * @param mem memory-buffer to store the result in or NULL to use malloc, should be aligned to 4 bytes.
+ * @param mem_size size of mem in bytes.
+ *
+ * @return packed url or NULL if mem is too small. If mem is NULL this value will need to be free:ed with free().
+ */
+URL_PARSER_LINKAGE parsed_url_packed* parse_url_pack(const parsed_url* parsed, void* mem, size_t mem_size);
+
+/**
+ * Check that mem contains a valid parsed_url_packed, i.e. that all components are within its size and
+ * '\0'-terminated. Use on parsed_url_packed read from disk or shared with other processes.
+ *
+ * @param mem memory containing the packed url, aligned to 4 bytes.
+ * @param mem_size size of mem in bytes.
+ *
+ * @return mem as a parsed_url_packed or NULL if it is not valid.
+ */
+URL_PARSER_LINKAGE const parsed_url_packed* parse_url_packed_check(const void* mem, size_t mem_size);
+
+/**
+ * Components of an url, used to get strings from a parsed_url_compact with parsed_url_compact_get().
+ */
+enum parse_url_component
+{
+	PARSE_URL_COMPONENT_SCHEME = 0,
+	PARSE_URL_COMPONENT_USER,
+	PARSE_URL_COMPONENT_PASS,
+	PARSE_URL_COMPONENT_HOST,
+	PARSE_URL_COMPONENT_PATH,
+	PARSE_URL_COMPONENT_QUERY,
+	PARSE_URL_COMPONENT_FRAGMENT,
+
+	PARSE_URL_COMPONENT_COUNT
+};
+
+/**
+ * Flags set in parsed_url_compact::flags.
+ */
+enum parsed_url_compact_flags
+{
+	PARSED_URL_COMPACT_PATH_ENCODED  = 1 << 0, // same as PARSED_URL_PATH_ENCODED.
+	PARSED_URL_COMPACT_PORT_EXPLICIT = 1 << 1, // same as PARSED_URL_PORT_EXPLICIT.
+	PARSED_URL_COMPACT_LONG          = 1 << 2  // a component is longer than 65534 bytes, lengths are stored in the pool.
+};
+
+/**
+ * Memory shared by many parsed_url_compact for their strings, initialize with parse_url_string_pool_init().
+ * Strings are appended at used and the pool never grows, at most 4GB can be used.
+ */
+struct parse_url_string_pool
+{
+	char*  mem;
+	size_t size;
+	size_t used;
+};
+
+/**
+ * Compact version of parsed_url, 24 bytes, for keeping large amounts of urls in memory, created by parse_url_compact().
+ *
+ * The strings of all components are stored one after the other in a parse_url_string_pool, starting at
+ * pool_offset, so only their lengths need to be stored. Get them with parsed_url_compact_get().
+ *
+ * @note the decoded ipv4 and ipv6 address and the query parameters of parsed_url are not stored.
+ */
+struct parsed_url_compact
+{
+	/**
+	 * offset of the first string of the url in the pool.
+	 */
+	uint32_t pool_offset;
+
+	/**
+	 * length of each component, indexed by parse_url_component, 0xFFFF if not present.
+	 * If PARSED_URL_COMPACT_LONG is set the lengths are instead stored as uint32_t, 0xFFFFFFFF if not
+	 * present, first in the pool at pool_offset.
+	 */
+	uint16_t lengths[PARSE_URL_COMPONENT_COUNT];
+
+	/**
+	 * same as the members of parsed_url with the same names.
+	 */
+	uint16_t port;
+	uint16_t scheme_id;
+	uint8_t  host_type;
+
+	/**
+	 * combination of parsed_url_compact_flags.
+	 */
+	uint8_t  flags;
+};
+
+/**
+ * Initialize pool to store strings in mem.
+ */
+URL_PARSER_LINKAGE void parse_url_string_pool_init(parse_url_string_pool* pool, void* mem, size_t mem_size);
+
+/**
+ * Calculate the amount of memory parse_url_compact() will use of the pool for parsed.
+ */
+URL_PARSER_LINKAGE size_t parse_url_compact_pool_usage(const parsed_url* parsed);
+
+/**
+ * Convert parsed to a parsed_url_compact with its strings stored in pool.
+ *
+ * @param parsed url to convert, can be freed or reused after the call.
+ * @param pool pool to store the strings in.
+ * @param out record to fill.
+ *
+ * @return false if there is not enough space in pool or scheme_id or port of parsed does not fit in 16 bits.
+ */
+URL_PARSER_LINKAGE bool parse_url_compact(const parsed_url* parsed, parse_url_string_pool* pool, parsed_url_compact* out);
+
+/**
+ * Get one component of compact.
+ *
+ * @param compact url to get component from.
+ * @param pool pool that compact was created in.
+ * @param component one of parse_url_component.
+ * @param len set to the length of the component.
+ *
+ * @return the component, that is not '\0'-terminated, or 0x0 if it is not present, the same as the member of parsed_url.
+ */
+URL_PARSER_LINKAGE const char* parsed_url_compact_get(const parsed_url_compact* compact, const parse_url_string_pool* pool, unsigned int component, size_t* len);
+
+/**
+ * Iterator over the parameters of a query-string, initialize with parse_url_query_iter_init()
+ * and step with parse_url_query_next().
+ */
+struct parse_url_query_iter
+{
+	const char* pos;
+	const char* end;
+};
+
+/**
+ * Initialize it to iterate over the parameters in query.
+ *
+ * @param it iterator to initialize.
+ * @param query query-string, without the leading '?', such as parsed_url::query. Can be 0x0.
+ * @param query_len length of query in bytes.
+ */
+URL_PARSER_LINKAGE void parse_url_query_iter_init(parse_url_query_iter* it, const char* query, size_t query_len);
+
+/**
+ * Get the next parameter from it. Parameters are separated by '&', empty parameters such as
+ * in "a=1&&b=2" are skipped. Nothing is copied or decoded.
+ *
+ * @param it iterator to step.
+ * @param param parameter to fill.
+ *
+ * @return false when there are no more parameters.
+ */
+URL_PARSER_LINKAGE bool parse_url_query_next(parse_url_query_iter* it, parsed_url_query_param* param);
+
+/**
+ * Split query into parameters, same as calling parse_url_query_next() until it returns false.
+ *
+ * @param query query-string, without the leading '?'. Can be 0x0.
+ * @param query_len length of query in bytes.
+ * @param params array to fill with at most max_params parameters, can be 0x0 if max_params is 0.
+ * @param max_params size of params.
+ *
+ * @return number of parameters in query, this might be more than max_params.
+ */
+URL_PARSER_LINKAGE size_t parse_url_query_split(const char* query, size_t query_len, parsed_url_query_param* params, size_t max_params);
+
+/**
+ * Decode a key or value of a query-parameter as a form-value, i.e. '+' is decoded as ' ' and
+ * percent-encoded values are decoded, to dst as a '\0'-terminated string.
+ *
+ * @param src key or value to decode, as parsed_url_query_param::value.
+ * @param src_len length of src in bytes.
+ * @param dst buffer to decode to.
+ * @param dst_size size of dst in bytes, src_len + 1 is always enough.
+ *
+ * @return dst or 0x0 if dst was to small or src contained invalid percent-encoding.
+ */
+URL_PARSER_LINKAGE const char* parse_url_query_decode(const char* src, size_t src_len, char* dst, size_t dst_size);
+
+/**
+ * Calculate the amount of memory needed for a parse_url_query_index over num_params parameters.
+ */
+URL_PARSER_LINKAGE size_t parse_url_query_index_calc_mem_usage(size_t num_params);
+
+/**
+ * Build a hash-index over params, to find parameters by key in O(1) expected time instead of
+ * scanning the query once per key.
+ *
+ * @param params parameters to index, need to outlive the index.
+ * @param num_params number of parameters in params.
+ * @param mem memory-buffer to place the index in.
+ * @param mem_size size of mem in bytes, see parse_url_query_index_calc_mem_usage().
+ *
+ * @return the index or 0x0 if mem was to small.
+ */
+URL_PARSER_LINKAGE const parse_url_query_index* parse_url_query_index_build(const parsed_url_query_param* params, size_t num_params, void* mem, size_t mem_size);
+
+/**
+ * Find the first parameter with key in index. Keys are compared as they are in the url, i.e.
+ * case-sensitive and without decoding.
+ *
+ * @return the parameter or 0x0 if not found.
+ */
+URL_PARSER_LINKAGE const parsed_url_query_param* parse_url_query_index_get(const parse_url_query_index* index, const char* key, size_t key_len);
+
+/**
+ * Find the first query-parameter with key in an url parsed with PARSE_URL_FLAG_QUERY_PARAMS or
+ * PARSE_URL_FLAG_QUERY_INDEX. Lookup is done in parsed_url::query_index if available, otherwise
+ * parsed_url::query_params is searched.
+ *
+ * @return the parameter or 0x0 if not found or if the url was not parsed with one of the flags above.
+ */
+URL_PARSER_LINKAGE const parsed_url_query_param* parse_url_get_param(const parsed_url* parsed, const char* key);
+
+/**
+ * Scheme to register with parse_url_scheme_table_build().
+ */
+struct parse_url_scheme_def
+{
+	const char*  name;         // name of scheme, such as "myproto", compared case-insensitive.
+	unsigned int default_port; // port to use when the url has no explicit port, 0 - 65535.
+};
+
+/**
+ * Immutable lookup-table of user-registered schemes, see parse_url_scheme_table_build().
+ */
+struct parse_url_scheme_table;
+
+/**
+ * Calculate the amount of memory needed for a parse_url_scheme_table of the specified schemes.
+ */
+URL_PARSER_LINKAGE size_t parse_url_scheme_table_calc_mem_usage(const parse_url_scheme_def* schemes, size_t num_schemes);
+
+/**
+ * Build a lookup-table of schemes to pass to parse_url_set_scheme_table(). Schemes are given
+ * ids from PARSE_URL_SCHEME_USER_FIRST in the order they are in schemes, the names are copied.
+ * Registered schemes are checked before the builtin ones so a builtin default port can be overridden.
+ *
+ * @param schemes schemes to register.
+ * @param num_schemes number of schemes in schemes.
+ * @param mem memory-buffer to place the table in, need to outlive all parsing with the table.
+ * @param mem_size size of mem in bytes, see parse_url_scheme_table_calc_mem_usage().
+ *
+ * @return the table or 0x0 if mem was to small or a default_port is above 65535.
+ */
+URL_PARSER_LINKAGE const parse_url_scheme_table* parse_url_scheme_table_build(const parse_url_scheme_def* schemes, size_t num_schemes, void* mem, size_t mem_size);
+
+/**
+ * Set the table of user-registered schemes used by all parsing or 0x0 to only use the builtin schemes.
+ *
+ * @note this is not synchronized with parsing on other threads, set it at startup before any parsing.
+ */
+URL_PARSER_LINKAGE void parse_url_set_scheme_table(const parse_url_scheme_table* table);
+
+/**
+ * Parse an url into ranges into the original string without copying or allocating anything.
+ * The url is validated the same way as by parse_url().
+ *
+ * @param url url to parse, need to outlive out.
+ * @param out view to fill.
+ *
+ * @return false if url could not be parsed.
+ */
+URL_PARSER_LINKAGE bool parse_url_view(const char* url, parsed_url_view* out);
+
+/**
+ * Same as parse_url_view() but parse the first url_len bytes of url, url does not need to be
+ * '\0'-terminated and no byte after url_len will be read.
+ */
+URL_PARSER_LINKAGE bool parse_url_view_n(const char* url, size_t url_len, parsed_url_view* out);
+
+/**
+ * Calculate the exact amount of memory parse_url_from_view() will use for view. The url has already
+ * been scanned by parse_url_view() so, unlike parse_url_calc_mem_usage(), nothing needs to be scanned
+ * again unless PARSE_URL_FLAG_QUERY_PARAMS or PARSE_URL_FLAG_QUERY_INDEX is set.
+ *
+ * @note the result is exact if mem is aligned to sizeof(void*), as memory from malloc() and
+ *       parse_url_buffer is. Add sizeof(void*) - 1 bytes otherwise.
+ *
+ * @param view url to calculate memory usage of.
+ * @param flags combination of parse_url_flags that will be passed to parse_url_from_view().
+ */
+URL_PARSER_LINKAGE size_t parse_url_view_calc_mem_usage(const parsed_url_view* view, unsigned int flags = 0);
+
+/**
+ * Create a parsed_url from a view filled by parse_url_view(), the same as parse_url() would return
+ * for the url of view but without scanning the url again.
+ *
+ * @param view url to create parsed_url from, view->url has to be valid during the call.
+ * @param mem memory-buffer to use or NULL to use malloc, see parse_url_view_calc_mem_usage().
+ * @param mem_size size of mem in bytes.
+ * @param flags combination of parse_url_flags.
+ *
+ * @return parsed url or NULL if mem is too small. If mem is NULL this value will need to be free:ed with free().
+ */
+URL_PARSER_LINKAGE parsed_url* parse_url_from_view(const parsed_url_view* view, void* mem, size_t mem_size, unsigned int flags = 0);
+
+/**
+ * Callbacks used by parse_url_arena to allocate and free chunks.
+ */
+typedef void* (*parse_url_arena_alloc_func)(size_t size, void* userdata);
+typedef void  (*parse_url_arena_free_func)(void* ptr, void* userdata);
+
+/**
+ * Header of one chunk of memory in a parse_url_arena.
+ */
+struct parse_url_arena_chunk
+{
+	parse_url_arena_chunk* next;
+	size_t                 size; // size of chunk, including this header.
+};
+
+/**
+ * Arena that many urls can be parsed into, growing in chunks as needed. All urls are freed at once by
+ * parse_url_arena_reset() that keeps the chunks for the next urls, so for example urls parsed during
+ * one request can be freed at the end of it without any allocations in the next one.
+ *
+ * Initialize with parse_url_arena_init(), free all chunks with parse_url_arena_destroy().
+ */
+struct parse_url_arena
+{
+	parse_url_arena_alloc_func alloc_func;
+	parse_url_arena_free_func  free_func;
+	void*                      userdata;
+	size_t                     chunk_size;
+
+	parse_url_arena_chunk*     first;   // all chunks, in the order they are used.
+	parse_url_arena_chunk*     current; // chunk that is currently allocated from.
+	size_t                     pos;     // bytes used of current.
+
+	/**
+	 * statistics, bytes used since last reset, the highest used has ever been and the total size of
+	 * all chunks. used includes alignment and the ends of chunks that were left when moving to the next one.
+	 */
+	size_t                     used;
+	size_t                     high_water;
+	size_t                     allocated;
+};
+
+/**
+ * Initialize arena.
+ *
+ * @param arena arena to initialize.
+ * @param chunk_size minimum size of chunks, larger chunks are allocated for allocations that do not fit.
+ * @param alloc function to allocate chunks with or NULL to use malloc, see URL_PARSER_MALLOC.
+ * @param free_func function to free chunks with or NULL to use free, see URL_PARSER_FREE.
+ * @param userdata passed to alloc and free_func.
+ */
+URL_PARSER_LINKAGE void parse_url_arena_init(parse_url_arena* arena, size_t chunk_size, parse_url_arena_alloc_func alloc = 0x0, parse_url_arena_free_func free_func = 0x0, void* userdata = 0x0);
+
+/**
+ * Free all chunks of arena, all urls parsed into arena are invalid after this.
+ */
+URL_PARSER_LINKAGE void parse_url_arena_destroy(parse_url_arena* arena);
+
+/**
+ * Free all urls parsed into arena in O(1), the chunks are kept and reused.
+ */
+URL_PARSER_LINKAGE void parse_url_arena_reset(parse_url_arena* arena);
+
+/**
+ * Allocate size bytes, aligned to sizeof(void*), from arena. Can be used as mem to any of the other
+ * functions, such as parse_url_resolve() with parse_url_resolve_calc_mem_usage() bytes.
+ *
+ * @return memory or NULL if a new chunk was needed and could not be allocated.
+ */
+URL_PARSER_LINKAGE void* parse_url_arena_alloc(parse_url_arena* arena, size_t size);
+
+/**
+ * Parse url into arena, only the exact memory needed is used, see parse_url_view_calc_mem_usage().
+ *
+ * @return parsed url, valid until arena is reset or destroyed, or NULL if url is invalid or memory could not be allocated.
+ */
+URL_PARSER_LINKAGE parsed_url* parse_url_arena_parse(parse_url_arena* arena, const char* url, unsigned int flags = 0);
+
+/**
+ * Same as parse_url_arena_parse() but as parse_url_n().
+ */
+URL_PARSER_LINKAGE parsed_url* parse_url_arena_parse_n(parse_url_arena* arena, const char* url, size_t url_len, unsigned int flags = 0);
+
+/**
+ * Copy a component from a parsed_url_view to dst as a lower-cased, '\0'-terminated string.
+ * Lower-casing is done the same way as by parse_url(), ascii-only and independent of locale.
+ *
+ * @param view view that range belongs to.
+ * @param range range to copy, for example view->host.
+ * @param dst buffer to copy to.
+ * @param dst_size size of dst in bytes, need to be at least range.length + 1.
+ *
+ * @return dst or 0x0 if dst was to small.
+ */
+URL_PARSER_LINKAGE const char* parse_url_view_copy_lower(const parsed_url_view* view, parsed_url_range range, char* dst, size_t dst_size);
+
+/**
+ * Copy a component from a parsed_url_view to dst as a percent-decoded, '\0'-terminated string.
+ *
+ * @param view view that range belongs to.
+ * @param range range to copy, for example view->path.
+ * @param dst buffer to copy to.
+ * @param dst_size size of dst in bytes, range.length + 1 is always enough.
+ *
+ * @return dst or 0x0 if dst was to small or range contained invalid percent-encoding.
+ */
+URL_PARSER_LINKAGE const char* parse_url_view_decode(const parsed_url_view* view, parsed_url_range range, char* dst, size_t dst_size);
+
+/**
+ * Calculate the amount of memory needed to parse all the specified urls with parse_url_batch().
+ *
+ * @param urls urls to parse.
+ * @param num_urls number of urls in urls.
+ */
+URL_PARSER_LINKAGE size_t parse_url_batch_calc_mem_usage(const char** urls, size_t num_urls);
+
+/**
+ * Parse many urls into one memory-buffer.
+ * The results are packed one after the other in mem in the same order as urls, a failed url does not
+ * stop the batch and does not use any memory.
+ *
+ * @param urls urls to parse.
+ * @param num_urls number of urls in urls.
+ * @param mem memory-buffer to parse all urls into, parse_url_batch_calc_mem_usage() bytes is always enough.
+ * @param mem_size size of mem in bytes.
+ * @param out array of num_urls parsed_url*, out[i] will be set to the result of urls[i] or 0x0 if it failed to parse.
+ *
+ * @return number of urls that was successfully parsed.
+ */
+URL_PARSER_LINKAGE size_t parse_url_batch(const char** urls, size_t num_urls, void* mem, size_t mem_size, parsed_url** out);
+
+/**
+ * Same as parse_url_batch() but the urls are split into chunks that are parsed by num_threads threads.
+ *
+ * Chunks are balanced between threads by work-stealing and each chunk is parsed into its own part of
+ * mem, so no locking is needed when allocating. The result, including where in mem each url is placed,
+ * does not depend on num_threads or on what thread parsed what chunk.
+ *
+ * If mem is too small to fit every chunk, parse_url_batch_calc_mem_usage() bytes is always enough, the urls
+ * are parsed by parse_url_batch() on the calling thread instead. The result is then the same as by
+ * parse_url_batch() instead of failing whole chunks.
+ *
+ * @param num_threads number of threads to use, including the calling thread, 0 to use one per core.
+ *
+ * @note compile with URL_PARSER_NO_THREADS to remove the dependency on <thread>, all chunks will then
+ *       be parsed by the calling thread.
+ */
+URL_PARSER_LINKAGE size_t parse_url_batch_parallel(const char** urls, size_t num_urls, void* mem, size_t mem_size, parsed_url** out, unsigned int num_threads);
+
+/**
+ * State of an url that is parsed while it arrives in chunks, for example a request-target split
+ * over multiple reads from a socket. The stream is placed in user memory with parse_url_stream_init()
+ * and chunks are added with parse_url_stream_feed(). Component boundaries are found as the chunks
+ * arrive so that parse_url_stream_finish() only has to look at the last few bytes.
+ */
+struct parse_url_stream;
+
+/**
+ * Calculate the amount of memory needed for a parse_url_stream that can hold urls up to max_url_len bytes.
+ * @param max_url_len max length of url that will be fed to the stream.
+ */
+URL_PARSER_LINKAGE size_t parse_url_stream_calc_mem_usage(size_t max_url_len);
+
+/**
+ * Initialize a parse_url_stream in mem, call again on the same mem to parse the next url.
+ *
+ * @param mem memory-buffer to place the stream in, need to outlive the stream.
+ * @param mem_size size of mem in bytes.
+ *
+ * @return initialized stream or 0x0 if mem was to small.
+ */
+URL_PARSER_LINKAGE parse_url_stream* parse_url_stream_init(void* mem, size_t mem_size);
+
+/**
+ * Add the next chunk of the url to stream.
+ *
+ * @param stream stream to feed.
+ * @param data bytes to add, does not need to be '\0'-terminated and is copied into the stream.
+ * @param data_len length of data in bytes.
+ *
+ * @return false if the url is invalid or would not fit in the stream, all later calls on stream will fail.
+ */
+URL_PARSER_LINKAGE bool parse_url_stream_feed(parse_url_stream* stream, const char* data, size_t data_len);
+
+/**
+ * Finish parsing of all data fed to stream. Gives the same result as parse_url() on all chunks
+ * concatenated.
+ *
+ * @param stream stream to finish.
+ * @param mem memory-buffer to use to parse the url or NULL to use malloc.
+ * @param mem_size size of mem in bytes.
+ *
+ * @return parsed url or 0x0 on error. If mem is NULL this value will need to be free:ed with free().
+ */
+URL_PARSER_LINKAGE parsed_url* parse_url_stream_finish(parse_url_stream* stream, void* mem, size_t mem_size);
+
+/**
+ * Same as parse_url_stream_finish() but fill a parsed_url_view that points into the memory of stream.
+ *
+ * @return false if the url could not be parsed.
+ */
+URL_PARSER_LINKAGE bool parse_url_stream_finish_view(parse_url_stream* stream, parsed_url_view* out);
+
+
+
+
+#if defined(URL_PARSER_IMPLEMENTATION)
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(URL_PARSER_MALLOC)
+#  define URL_PARSER_MALLOC( size ) malloc( size )
+#  define URL_PARSER_FREE( ptr )    free( ptr )
+#endif
+
+#if !defined(URL_PARSER_NO_THREADS)
+#  include <atomic>
+#  include <thread>
+#endif
+
+#if !defined(URL_PARSER_NO_SIMD) && ( defined(__x86_64__) || defined(_M_X64) || ( defined(__i386__) && defined(__SSE2__) ) )
+#  define URL_PARSER_X86_SIMD
+#  include <immintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#    define URL_PARSER_TARGET_AVX2
+#  else
+#    define URL_PARSER_TARGET_AVX2 __attribute__((target("avx2")))
+#  endif
+#endif
+
+struct parse_url_ctx
+{
+	void* mem;
+	size_t memsize;
+	size_t memleft;
+};
+
+#define PARSE_URL_NPOS ((size_t)-1)
+
+const char* parse_url_strnchr( const char* str, size_t len, int ch )
+{
+	for( size_t i = 0; i < len; ++i )
+		if( str[i] == ch )
+			return &str[i];
+	return 0x0;
+}
+
+// ... parsed_url only contains pointers and ints ...
+static const size_t PARSE_URL_ALIGNMENT = sizeof( void* );
+
+static size_t parse_url_align_up( size_t size )
+{
+	return ( size + PARSE_URL_ALIGNMENT - 1 ) & ~( PARSE_URL_ALIGNMENT - 1 );
+}
+
+static bool parse_url_align_ctx( parse_url_ctx* ctx )
+{
+	size_t addr = (size_t)( (char*)ctx->mem + ctx->memsize - ctx->memleft );
+	size_t pad  = parse_url_align_up( addr ) - addr;
+	if( pad > ctx->memleft )
+		return false;
+	ctx->memleft -= pad;
+	return true;
+}
+
+static void* parse_url_alloc_mem( parse_url_ctx* ctx, size_t request_size )
+{
+	if( request_size > ctx->memleft )
+		return 0;
+	void* res = (char*)ctx->mem + ctx->memsize - ctx->memleft;
+	ctx->memleft -= request_size;
+	return res;
+}
+
+/**
+ * ascii-only lower-casing of c, not affected by the current locale.
+ */
+static char parse_url_ascii_lower( char c )
+{
+	return ( c >= 'A' && c <= 'Z' ) ? (char)( c + ( 'a' - 'A' ) ) : c;
+}
+
+/**
+ * Compare len chars of scheme case-insensitive to the lower-cased name.
+ */
+static bool parse_url_scheme_eq( const char* scheme, const char* name, size_t len )
+{
+	for( size_t i = 0; i < len; ++i )
+		if( parse_url_ascii_lower( scheme[i] ) != name[i] )
+			return false;
+	return true;
+}
+
+struct parse_url_builtin_scheme
+{
+	const char*    name;
+	unsigned char  len;
+	unsigned short port;
+	unsigned char  id;
+};
+
+/**
+ * All builtin schemes sorted on first char, parse_url_scheme_first_char[c - 'a'] is the first
+ * scheme starting with c and parse_url_scheme_first_char[c - 'a' + 1] is one past the last.
+ */
+static const parse_url_builtin_scheme parse_url_builtin_schemes[] =
+{
+	{ "amqp",        4,  5672, PARSE_URL_SCHEME_AMQP },
+	{ "amqps",       5,  5671, PARSE_URL_SCHEME_AMQPS },
+	{ "ftp",         3,    21, PARSE_URL_SCHEME_FTP },
+	{ "file",        4,     0, PARSE_URL_SCHEME_FILE },
+	{ "ftps",        4,   990, PARSE_URL_SCHEME_FTPS },
+	{ "git",         3,  9418, PARSE_URL_SCHEME_GIT },
+	{ "gopher",      6,    70, PARSE_URL_SCHEME_GOPHER },
+	{ "http",        4,    80, PARSE_URL_SCHEME_HTTP },
+	{ "https",       5,   443, PARSE_URL_SCHEME_HTTPS },
+	{ "imap",        4,   143, PARSE_URL_SCHEME_IMAP },
+	{ "imaps",       5,   993, PARSE_URL_SCHEME_IMAPS },
+	{ "ldap",        4,   389, PARSE_URL_SCHEME_LDAP },
+	{ "ldaps",       5,   636, PARSE_URL_SCHEME_LDAPS },
+	{ "mysql",       5,  3306, PARSE_URL_SCHEME_MYSQL },
+	{ "mongodb",     7, 27017, PARSE_URL_SCHEME_MONGODB },
+	{ "mqtt",        4,  1883, PARSE_URL_SCHEME_MQTT },
+	{ "mqtts",       5,  8883, PARSE_URL_SCHEME_MQTTS },
+	{ "nntp",        4,   119, PARSE_URL_SCHEME_NNTP },
+	{ "pop3",        4,   110, PARSE_URL_SCHEME_POP3 },
+	{ "pop3s",       5,   995, PARSE_URL_SCHEME_POP3S },
+	{ "postgres",    8,  5432, PARSE_URL_SCHEME_POSTGRES },
+	{ "postgresql", 10,  5432, PARSE_URL_SCHEME_POSTGRESQL },
+	{ "rtsp",        4,   554, PARSE_URL_SCHEME_RTSP },
+	{ "redis",       5,  6379, PARSE_URL_SCHEME_REDIS },
+	{ "rediss",      6,  6379, PARSE_URL_SCHEME_REDISS },
+	{ "ssh",         3,    22, PARSE_URL_SCHEME_SSH },
+	{ "sftp",        4,    22, PARSE_URL_SCHEME_SFTP },
+	{ "smtp",        4,    25, PARSE_URL_SCHEME_SMTP },
+	{ "sip",         3,  5060, PARSE_URL_SCHEME_SIP },
+	{ "sips",        4,  5061, PARSE_URL_SCHEME_SIPS },
+	{ "telnet",      6,    23, PARSE_URL_SCHEME_TELNET },
+	{ "ws",          2,    80, PARSE_URL_SCHEME_WS },
+	{ "wss",         3,   443, PARSE_URL_SCHEME_WSS }
+};
+
+static const unsigned char parse_url_scheme_first_char[27] =
+{
+	 0,  2,  2,  2,  2,  2,  5,  7,  9, 11, 11, 11, 13, 17, 18, 18, 22, 22, 25, 30, 31, 31, 31, 33, 33, 33, 33
+};
+
+struct parse_url_scheme_table
+{
+	const parse_url_scheme_def* schemes;   // names are lower-cased
+	size_t                      num_schemes;
+	unsigned int*               slots;     // index + 1 into schemes, 0 for empty slots
+	size_t                      slot_mask; // number of slots - 1, always a power of 2
+};
+
+static const parse_url_scheme_table* parse_url_user_schemes = 0x0;
+
+/**
+ * FNV-1a of the lower-cased scheme.
+ */
+static unsigned int parse_url_hash_scheme( const char* scheme, size_t len )
+{
+	unsigned int hash = 2166136261u;
+	for( size_t i = 0; i < len; ++i )
+		hash = ( hash ^ (unsigned char)parse_url_ascii_lower( scheme[i] ) ) * 16777619u;
+	return hash;
+}
+
+/**
+ * Find the id and default port of scheme, first in the user-registered schemes and then
+ * in the builtin ones.
+ */
+static unsigned int parse_url_lookup_scheme( const char* scheme, size_t len, unsigned int* port )
+{
+	*port = 0;
+
+	const parse_url_scheme_table* table = parse_url_user_schemes;
+	if( table != 0x0 )
+	{
+		size_t slot = parse_url_hash_scheme( scheme, len ) & table->slot_mask;
+		for( unsigned int index; ( index = table->slots[slot] ) != 0; slot = ( slot + 1 ) & table->slot_mask )
+		{
+			const parse_url_scheme_def* def = table->schemes + index - 1;
+			if( strlen( def->name ) == len && parse_url_scheme_eq( scheme, def->name, len ) )
+			{
+				*port = def->default_port;
+				return PARSE_URL_SCHEME_USER_FIRST + index - 1;
+			}
+		}
+	}
+
+	unsigned int first = (unsigned char)parse_url_ascii_lower( len > 0 ? scheme[0] : '\0' );
+	if( first < 'a' || first > 'z' )
+		return PARSE_URL_SCHEME_UNKNOWN;
+
+	for( unsigned int i = parse_url_scheme_first_char[first - 'a']; i < parse_url_scheme_first_char[first - 'a' + 1]; ++i )
+	{
+		const parse_url_builtin_scheme* builtin = parse_url_builtin_schemes + i;
+		if( builtin->len == len && parse_url_scheme_eq( scheme + 1, builtin->name + 1, len - 1 ) )
+		{
+			*port = builtin->port;
+			return builtin->id;
+		}
+	}
+	return PARSE_URL_SCHEME_UNKNOWN;
+}
+
+static char* parse_url_alloc_string( parse_url_ctx* ctx, const char* src, size_t len)
+{
+	char* dst = (char*)parse_url_alloc_mem( ctx, len + 1 );
+	if( dst == 0x0 )
+		return 0x0;
+	memcpy( dst, src, len );
+	dst[len] = '\0';
+	return dst;
+}
+
+/**
+ * Copy len chars from src to dst and lower-case 'A'-'Z' on the way. Only ascii is lower-cased,
+ * so unlike tolower() the result does not depend on the current locale.
+ */
+static void parse_url_copy_lower( char* dst, const char* src, size_t len )
+{
+	size_t i = 0;
+#if defined(URL_PARSER_X86_SIMD)
+	// ... chars >= 0x80 are negative as signed bytes and will never be in 'A'-'Z' ...
+	const __m128i before_a = _mm_set1_epi8( 'A' - 1 );
+	const __m128i after_z  = _mm_set1_epi8( 'Z' + 1 );
+	const __m128i case_bit = _mm_set1_epi8( 0x20 );
+	for( ; i + 16 <= len; i += 16 )
+	{
+		__m128i chars = _mm_loadu_si128( (const __m128i*)( src + i ) );
+		__m128i upper = _mm_and_si128( _mm_cmpgt_epi8( chars, before_a ), _mm_cmplt_epi8( chars, after_z ) );
+		_mm_storeu_si128( (__m128i*)( dst + i ), _mm_or_si128( chars, _mm_and_si128( upper, case_bit ) ) );
+	}
+#endif
+	for( ; i < len; ++i )
+		dst[i] = parse_url_ascii_lower( src[i] );
+}
+
+static const char* parse_url_alloc_lower_string( parse_url_ctx* ctx, const char* src, size_t len)
+{
+	char* dst = (char*)parse_url_alloc_mem( ctx, len + 1 );
+	if( dst == 0x0 )
+		return 0x0;
+	parse_url_copy_lower( dst, src, len );
+	dst[len] = '\0';
+	return dst;
+}
+
+static unsigned int parse_url_count_trailing_zeros( uint64_t mask )
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64( &index, mask );
+	return (unsigned int)index;
+#elif defined(_MSC_VER)
+	unsigned long index;
+	if( _BitScanForward( &index, (unsigned long)mask ) )
+		return (unsigned int)index;
+	_BitScanForward( &index, (unsigned long)( mask >> 32 ) );
+	return (unsigned int)index + 32;
+#else
+	return (unsigned int)__builtin_ctzll( mask );
+#endif
+}
+
+/**
+ * Value of each char as a hex-digit, PARSE_URL_HEX_INVALID for all chars that are not hex-digits.
+ */
+#define PARSE_URL_HEX_INVALID 0x80
+#define PARSE_URL_HX_IV PARSE_URL_HEX_INVALID
+static const unsigned char parse_url_hex_value[256] =
+{
+	PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, // 0x00
+	PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, // 0x10
+	PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, // 0x20
+	0,               1,               2,               3,               4,               5,               6,               7,               8,               9,               PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, // 0x30
+	PARSE_URL_HX_IV, 10,              11,              12,              13,              14,              15,              PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, // 0x40
+	PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, // 0x50
+	PARSE_URL_HX_IV, 10,              11,              12,              13,              14,              15,              PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, // 0x60
+	PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, // 0x70
+	PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, // 0x80
+	PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, // 0x90
+	PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, // 0xa0
+	PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, // 0xb0
+	PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, // 0xc0
+	PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, // 0xd0
+	PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, // 0xe0
+	PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV, PARSE_URL_HX_IV  // 0xf0
+};
+#undef PARSE_URL_HX_IV
+
+static bool parse_url_is_hex_char( char c )
+{
+	return parse_url_hex_value[(unsigned char)c] != PARSE_URL_HEX_INVALID;
+}
+
+/**
+ * Decode the escape "%xx" at src into dst, src need to have 3 readable bytes.
+ * Return false if xx is not 2 hex-digits.
+ */
+static bool parse_url_decode_escape( char* dst, const char* src )
+{
+	unsigned int hi = parse_url_hex_value[(unsigned char)src[1]];
+	unsigned int lo = parse_url_hex_value[(unsigned char)src[2]];
+	if( ( hi | lo ) & PARSE_URL_HEX_INVALID )
+		return false;
+	*dst = (char)( ( hi << 4 ) | lo );
+	return true;
+}
+
+/**
+ * Decode len bytes of percent-encoded src into dst, dst can be the same as src.
+ * Return the decoded length or PARSE_URL_NPOS if src contains an invalid encoding.
+ */
+static size_t parse_url_unescape_percent_encoding( char* dst, const char* src, size_t len )
+{
+	const char* read  = src;
+	const char* end   = src + len;
+	char*       write = dst;
+
+#if defined(URL_PARSER_X86_SIMD)
+	// ... copy 16 bytes at the time up to the next '%', a decoded string is never longer than the
+	//     encoded one so storing a full 16 bytes never write past dst + len. When decoding in place
+	//     a store could overwrite bytes that is not read yet if write is less than 16 bytes behind read ...
+	bool overlap = (size_t)dst < (size_t)end && (size_t)src < (size_t)dst + len;
+	const __m128i percent = _mm_set1_epi8( '%' );
+
+	while( end - read >= 16 )
+	{
+		__m128i      chars = _mm_loadu_si128( (const __m128i*)read );
+		unsigned int mask  = (unsigned int)_mm_movemask_epi8( _mm_cmpeq_epi8( chars, percent ) );
+		size_t       run   = mask ? parse_url_count_trailing_zeros( mask ) : 16;
+
+		if( !overlap || read == write || read - write >= 16 )
+			_mm_storeu_si128( (__m128i*)write, chars );
+		else
+			memmove( write, read, run );
+		read  += run;
+		write += run;
+
+		// ... escapes often come in long runs, as with utf-8 encoded text, decode all of them before the next load ...
+		while( read < end && *read == '%' )
+		{
+			if( end - read < 3 || !parse_url_decode_escape( write, read ) )
+				return PARSE_URL_NPOS;
+			read  += 3;
+			write += 1;
+		}
+	}
+#endif
+
+	while( read < end )
+	{
+		if( *read == '%' )
+		{
+			if( end - read < 3 || !parse_url_decode_escape( write, read ) )
+				return PARSE_URL_NPOS;
+			read += 3;
+		}
+		else
+		{
+			*write = *read;
+			++read;
+		}
+		++write;
+	}
+	return (size_t)( write - dst );
+}
+
+static char* parse_url_alloc_decoded_string( parse_url_ctx* ctx, const char* src, size_t len )
+{
+	char* dst = (char*)parse_url_alloc_mem( ctx, len + 1 );
+	if( dst == 0x0 )
+		return 0x0;
+	size_t dst_len = parse_url_unescape_percent_encoding( dst, src, len );
+	if( dst_len == PARSE_URL_NPOS )
+		return 0x0;
+	dst[dst_len] = '\0';
+	return dst;
+}
+
+/**
+ * Decode len chars of s as a dotted-decimal ipv4 address as specified by RFC3986, i.e. exactly
+ * 4 numbers in 0-255 without leading zeros.
+ */
+static bool parse_url_decode_ipv4( const char* s, size_t len, uint32_t* out )
+{
+	uint32_t addr = 0;
+	size_t   i    = 0;
+	for( int octet = 0; octet < 4; ++octet )
+	{
+		if( octet > 0 )
+		{
+			if( i >= len || s[i] != '.' )
+				return false;
+			++i;
+		}
+
+		size_t       start = i;
+		unsigned int value = 0;
+		while( i < len && i - start < 3 && s[i] >= '0' && s[i] <= '9' )
+			value = value * 10 + (unsigned int)( s[i++] - '0' );
+
+		size_t digits = i - start;
+		if( digits == 0 || value > 255 || ( digits > 1 && s[start] == '0' ) )
+			return false;
+		addr = ( addr << 8 ) | value;
+	}
+
+	if( i != len )
+		return false;
+	*out = addr;
+	return true;
+}
+
+/**
+ * Decode len chars of s as an ipv6 address as specified by RFC4291, with "::" compression and
+ * an embedded ipv4 address as the last 32 bits. out is filled in network byte-order.
+ */
+static bool parse_url_decode_ipv6( const char* s, size_t len, uint8_t out[16] )
+{
+	unsigned int groups[8];
+	int          num_groups  = 0;
+	int          compress_at = -1;
+	size_t       i           = 0;
+
+	if( len >= 2 && s[0] == ':' && s[1] == ':' )
+	{
+		compress_at = 0;
+		i = 2;
+	}
+
+	while( i < len )
+	{
+		size_t       start = i;
+		unsigned int value = 0;
+		while( i < len && i - start < 5 && parse_url_is_hex_char( s[i] ) )
+			value = ( value << 4 ) | parse_url_hex_value[(unsigned char)s[i++]];
+
+		if( i < len && s[i] == '.' )
+		{
+			// ... embedded ipv4, has to be the last 2 groups ...
+			uint32_t ipv4;
+			if( num_groups > 6 || !parse_url_decode_ipv4( s + start, len - start, &ipv4 ) )
+				return false;
+			groups[num_groups++] = ipv4 >> 16;
+			groups[num_groups++] = ipv4 & 0xFFFF;
+			i = len;
+			break;
+		}
+
+		if( i == start || i - start > 4 || num_groups == 8 )
+			return false;
+		groups[num_groups++] = value;
+
+		if( i == len )
+			break;
+		if( s[i] != ':' || i + 1 == len )
+			return false;
+		++i;
+
+		if( s[i] == ':' )
+		{
+			if( compress_at >= 0 )
+				return false;
+			compress_at = num_groups;
+			++i;
+		}
+	}
+
+	if( compress_at < 0 ? num_groups != 8 : num_groups > 7 )
+		return false;
+
+	// ... expand "::" to as many 0-groups as needed to get 8 groups ...
+	int num_zero = 8 - num_groups;
+	int group    = 0;
+	for( int g = 0; g < num_groups; ++g )
+	{
+		if( g == compress_at )
+			for( int z = 0; z < num_zero; ++z, ++group )
+				out[group * 2] = out[group * 2 + 1] = 0;
+		out[group * 2]     = (uint8_t)( groups[g] >> 8 );
+		out[group * 2 + 1] = (uint8_t)( groups[g] & 0xFF );
+		++group;
+	}
+	for( ; group < 8; ++group )
+		out[group * 2] = out[group * 2 + 1] = 0;
+	return true;
+}
+
+/**
+ * Character classes used by the url-scanner, all chars that are not 0 in parse_url_char_class
+ * is a delimiter that might end or split a component.
+ * These are the same chars that parse_url_delim_mask_*() finds.
+ */
+enum parse_url_char_class_bits
+{
+	PARSE_URL_CC_AUTHORITY = 1 << 0, // ':', '@', '[', ']', '/'
+	PARSE_URL_CC_PERCENT   = 1 << 1, // '%'
+	PARSE_URL_CC_QUERY     = 1 << 2, // '?'
+	PARSE_URL_CC_FRAGMENT  = 1 << 3  // '#'
+};
+
+#define PARSE_URL_CC_A PARSE_URL_CC_AUTHORITY
+#define PARSE_URL_CC_P PARSE_URL_CC_PERCENT
+#define PARSE_URL_CC_Q PARSE_URL_CC_QUERY
+#define PARSE_URL_CC_F PARSE_URL_CC_FRAGMENT
+
+static const unsigned char parse_url_char_class[256] =
+{
+	//   0               1               2               3               4               5               6               7               8               9               A               B               C               D               E               F
+	0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              // 0x00
+	0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              // 0x10
+	0,              0,              0,              PARSE_URL_CC_F, 0,              PARSE_URL_CC_P, 0,              0,              0,              0,              0,              0,              0,              0,              0,              PARSE_URL_CC_A, // 0x20
+	0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              PARSE_URL_CC_A, 0,              0,              0,              0,              PARSE_URL_CC_Q, // 0x30
+	PARSE_URL_CC_A, 0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              // 0x40
+	0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              PARSE_URL_CC_A, 0,              PARSE_URL_CC_A, 0,              0,              // 0x50
+	0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              // 0x60
+	0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              // 0x70
+	0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              // 0x80
+	0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              // 0x90
+	0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              // 0xA0
+	0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              // 0xB0
+	0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              // 0xC0
+	0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              // 0xD0
+	0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              // 0xE0
+	0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0,              0               // 0xF0
+};
+
+#undef PARSE_URL_CC_A
+#undef PARSE_URL_CC_P
+#undef PARSE_URL_CC_Q
+#undef PARSE_URL_CC_F
+
+enum parse_url_scan_state
+{
+	PARSE_URL_SCAN_AUTHORITY, // scheme, user, pass, host and port
+	PARSE_URL_SCAN_PATH,
+	PARSE_URL_SCAN_QUERY,
+	PARSE_URL_SCAN_FRAGMENT
+};
+
+/**
+ * State of the single forward scan over an url done by parse_url_view(), each delimiter found
+ * is passed to parse_url_scan_delim() that records the component boundaries in out.
+ */
+struct parse_url_scanner
+{
+	parsed_url_view* out;
+	const char*      url;
+	size_t           len;
+
+	parse_url_scan_state state;
+
+	// ... mask of parse_url_char_class_bits that need to be handled in the current state ...
+	unsigned int interest;
+
+	// ... start of the component currently being scanned ...
+	size_t comp_start;
+
+	// ... authority-state, scheme can only be the part before the first ':' ...
+	bool   scheme_checked;
+	bool   in_brackets;
+	size_t host_start;
+	size_t host_colon;
+	size_t ipv6_end;
+};
+
+static const unsigned int PARSE_URL_SCAN_INTEREST[] =
+{
+	PARSE_URL_CC_AUTHORITY | PARSE_URL_CC_QUERY | PARSE_URL_CC_FRAGMENT, // PARSE_URL_SCAN_AUTHORITY
+	PARSE_URL_CC_PERCENT   | PARSE_URL_CC_QUERY | PARSE_URL_CC_FRAGMENT, // PARSE_URL_SCAN_PATH
+	PARSE_URL_CC_FRAGMENT,                                               // PARSE_URL_SCAN_QUERY
+	0                                                                    // PARSE_URL_SCAN_FRAGMENT
+};
+
+static void parse_url_scan_init( parse_url_scanner* s, parsed_url_view* out, size_t len )
+{
+	s->out            = out;
+	s->url            = out->url;
+	s->len            = len;
+	s->state          = PARSE_URL_SCAN_AUTHORITY;
+	s->interest       = PARSE_URL_SCAN_INTEREST[PARSE_URL_SCAN_AUTHORITY];
+	s->comp_start     = 0;
+	s->scheme_checked = false;
+	s->in_brackets    = false;
+	s->host_start     = 0;
+	s->host_colon     = PARSE_URL_NPOS;
+	s->ipv6_end       = PARSE_URL_NPOS;
+}
+
+static parsed_url_range parse_url_make_range( size_t start, size_t end )
+{
+	parsed_url_range range = { start, end - start };
+	return range;
+}
+
+static void parse_url_scan_enter( parse_url_scanner* s, parse_url_scan_state state, size_t comp_start )
+{
+	s->state      = state;
+	s->interest   = PARSE_URL_SCAN_INTEREST[state];
+	s->comp_start = comp_start;
+}
+
+/**
+ * Parse url[begin, end) as a port, fails on anything that is not a digit or if the value
+ * do not fit in 16 bits. Leading zeros are allowed as in RFC3986.
+ */
+static bool parse_url_parse_port( const char* url, size_t begin, size_t end, unsigned int* port )
+{
+	unsigned int value = 0;
+	for( size_t i = begin; i < end; ++i )
+	{
+		unsigned int digit = (unsigned int)( (unsigned char)url[i] - '0' );
+		if( digit > 9 )
+			return false;
+
+		// ... checked every digit so value never overflows on long runs of digits ...
+		value = value * 10 + digit;
+		if( value > 65535 )
+			return false;
+	}
+	*port = value;
+	return true;
+}
+
+static bool parse_url_scan_end_authority( parse_url_scanner* s, size_t end )
+{
+	parsed_url_view* out = s->out;
+
+	// ... no ending ']' ...
+	if( s->in_brackets )
+		return false;
+
+	if( out->flags & PARSED_URL_VIEW_HAS_SCHEME )
+		out->scheme_id = parse_url_lookup_scheme( s->url + out->scheme.offset, out->scheme.length, &out->port );
+
+	size_t host_end = end;
+	if( s->host_colon != PARSE_URL_NPOS )
+	{
+		host_end = s->host_colon;
+
+		// ... "host:" is allowed by RFC3986 and means the default port of the scheme ...
+		if( end > s->host_colon + 1 )
+		{
+			if( !parse_url_parse_port( s->url, s->host_colon + 1, end, &out->port ) )
+				return false;
+			out->flags |= PARSED_URL_VIEW_HAS_PORT;
+		}
+	}
+
+	if( s->ipv6_end != PARSE_URL_NPOS )
+	{
+		// ... only a port is allowed after the ending ']', the [] is stripped from the host ...
+		if( host_end != s->ipv6_end + 1 )
+			return false;
+		out->host   = parse_url_make_range( s->host_start + 1, s->ipv6_end );
+		out->flags |= PARSED_URL_VIEW_HAS_HOST;
+	}
+	else if( host_end > s->host_start )
+	{
+		out->host   = parse_url_make_range( s->host_start, host_end );
+		out->flags |= PARSED_URL_VIEW_HAS_HOST;
+
+		// ... most hosts are names and will fail on the first char ...
+		out->host_type = parse_url_decode_ipv4( s->url + s->host_start, host_end - s->host_start, &out->ipv4 ) ? PARSE_URL_HOST_IPV4 : PARSE_URL_HOST_REG_NAME;
+	}
+	return true;
+}
+
+static size_t parse_url_scan_authority_delim( parse_url_scanner* s, size_t i )
+{
+	parsed_url_view* out = s->out;
+	const char*      url = s->url;
+	char             c   = url[i];
+
+	if( s->in_brackets && c != ']' )
+	{
+		// ... the validation of the ipv6 address is done at ']' but the authority can't end within [] ...
+		return ( c == ':' || c == '@' || c == '[' ) ? i + 1 : PARSE_URL_NPOS;
+	}
+
+	switch( c )
+	{
+		case ':':
+			if( !s->scheme_checked )
+			{
+				// ... is this the user part of a user/pass pair or the separator host:port? ...
+				s->scheme_checked = true;
+				if( i + 1 < s->len && url[i + 1] == '/' )
+				{
+					if( i + 2 >= s->len || url[i + 2] != '/' )
+						return PARSE_URL_NPOS;
+
+					out->scheme   = parse_url_make_range( 0, i );
+					out->flags   |= PARSED_URL_VIEW_HAS_SCHEME;
+					s->host_start = i + 3;
+					return i + 3;
+				}
+			}
+			if( s->host_colon == PARSE_URL_NPOS )
+				s->host_colon = i;
+			return i + 1;
+
+		case '@':
+			if( out->flags & PARSED_URL_VIEW_HAS_USER )
+				return i + 1;
+
+			// ... everything up until now was user and pass, split at the first ':' ...
+			s->scheme_checked = true;
+			out->flags |= PARSED_URL_VIEW_HAS_USER;
+			if( s->host_colon == PARSE_URL_NPOS )
+				out->user = parse_url_make_range( s->host_start, i );
+			else
+			{
+				out->user   = parse_url_make_range( s->host_start, s->host_colon );
+				out->pass   = parse_url_make_range( s->host_colon + 1, i );
+				out->flags |= PARSED_URL_VIEW_HAS_PASS;
+			}
+			s->host_start = i + 1;
+			s->host_colon = PARSE_URL_NPOS;
+			s->ipv6_end   = PARSE_URL_NPOS;
+			return i + 1;
+
+		case '[':
+			// ... ipv6 host is always enclosed in a [] to handle the : in an ipv6 address.
+			s->scheme_checked = true;
+			if( i == s->host_start )
+				s->in_brackets = true;
+			return i + 1;
+
+		case ']':
+			if( s->in_brackets )
+			{
+				// ... verify that the host is actually a valid ipv6 address and decode it while at it ...
+				if( !parse_url_decode_ipv6( url + s->host_start + 1, i - s->host_start - 1, out->ipv6 ) )
+					return PARSE_URL_NPOS;
+				out->host_type = PARSE_URL_HOST_IPV6;
+				s->in_brackets = false;
+				s->ipv6_end    = i;
+			}
+			return i + 1;
+
+		default:
+			break;
+	}
+
+	// ... '/', '?' or '#' ends the authority ...
+	s->scheme_checked = true;
+	if( !parse_url_scan_end_authority( s, i ) )
+		return PARSE_URL_NPOS;
+
+	switch( c )
+	{
+		case '/': parse_url_scan_enter( s, PARSE_URL_SCAN_PATH,     i );     break;
+		case '?': parse_url_scan_enter( s, PARSE_URL_SCAN_QUERY,    i + 1 ); break;
+		default:  parse_url_scan_enter( s, PARSE_URL_SCAN_FRAGMENT, i + 1 ); break;
+	}
+	return i + 1;
+}
+
+/**
+ * Handle the delimiter at url[i], return position to continue the scan at or PARSE_URL_NPOS
+ * if the url is invalid.
+ */
+static size_t parse_url_scan_delim( parse_url_scanner* s, size_t i )
+{
+	parsed_url_view* out = s->out;
+	const char*      url = s->url;
+
+	switch( s->state )
+	{
+		case PARSE_URL_SCAN_AUTHORITY:
+			return parse_url_scan_authority_delim( s, i );
+
+		case PARSE_URL_SCAN_PATH:
+			switch( url[i] )
+			{
+				case '%':
+					// ... decoding is done when the path is copied, but invalid encodings should fail the parse ...
+					if( i + 2 >= s->len || !parse_url_is_hex_char( url[i + 1] ) || !parse_url_is_hex_char( url[i + 2] ) )
+						return PARSE_URL_NPOS;
+					out->flags |= PARSED_URL_VIEW_PATH_ENCODED;
+					return i + 3;
+				case '?':
+					out->path   = parse_url_make_range( s->comp_start, i );
+					out->flags |= PARSED_URL_VIEW_HAS_PATH;
+					parse_url_scan_enter( s, PARSE_URL_SCAN_QUERY, i + 1 );
+					return i + 1;
+				default:
+					out->path   = parse_url_make_range( s->comp_start, i );
+					out->flags |= PARSED_URL_VIEW_HAS_PATH;
+					parse_url_scan_enter( s, PARSE_URL_SCAN_FRAGMENT, i + 1 );
+					return i + 1;
+			}
+
+		case PARSE_URL_SCAN_QUERY:
+			out->query  = parse_url_make_range( s->comp_start, i );
+			out->flags |= PARSED_URL_VIEW_HAS_QUERY;
+			parse_url_scan_enter( s, PARSE_URL_SCAN_FRAGMENT, i + 1 );
+			return i + 1;
+
+		case PARSE_URL_SCAN_FRAGMENT:
+			break;
+	}
+	return i + 1;
+}
+
+/**
+ * Delimiter kernels, finds all chars in the first len bytes of block that has a non-zero
+ * parse_url_char_class and return them as a bitmask with bit n set if block[n] is a delimiter.
+ * len need to be <= 64, chars not handled by the vector-loop are handled by the scalar version.
+ */
+typedef uint64_t (*parse_url_delim_mask_func)( const char* block, size_t len );
+
+static uint64_t parse_url_delim_mask_scalar_range( const char* block, size_t begin, size_t len )
+{
+	uint64_t mask = 0;
+	for( size_t i = begin; i < len; ++i )
+		mask |= (uint64_t)( parse_url_char_class[(unsigned char)block[i]] != 0 ) << i;
+	return mask;
+}
+
+static uint64_t parse_url_delim_mask_scalar( const char* block, size_t len )
+{
+	return parse_url_delim_mask_scalar_range( block, 0, len );
+}
+
+#if defined(URL_PARSER_X86_SIMD)
+static uint64_t parse_url_delim_mask_sse2( const char* block, size_t len )
+{
+	const __m128i colon   = _mm_set1_epi8( ':' );
+	const __m128i slash   = _mm_set1_epi8( '/' );
+	const __m128i at      = _mm_set1_epi8( '@' );
+	const __m128i quest   = _mm_set1_epi8( '?' );
+	const __m128i hash    = _mm_set1_epi8( '#' );
+	const __m128i lbrack  = _mm_set1_epi8( '[' );
+	const __m128i rbrack  = _mm_set1_epi8( ']' );
+	const __m128i percent = _mm_set1_epi8( '%' );
+
+	uint64_t mask = 0;
+	size_t   i    = 0;
+	for( ; i + 16 <= len; i += 16 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i*)( block + i ) );
+		__m128i m = _mm_or_si128( _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( v, colon  ), _mm_cmpeq_epi8( v, slash   ) ),
+												_mm_or_si128( _mm_cmpeq_epi8( v, at     ), _mm_cmpeq_epi8( v, quest   ) ) ),
+								  _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( v, hash   ), _mm_cmpeq_epi8( v, lbrack  ) ),
+												_mm_or_si128( _mm_cmpeq_epi8( v, rbrack ), _mm_cmpeq_epi8( v, percent ) ) ) );
+		mask |= (uint64_t)(unsigned int)_mm_movemask_epi8( m ) << i;
+	}
+	return mask | parse_url_delim_mask_scalar_range( block, i, len );
+}
+
+URL_PARSER_TARGET_AVX2 static uint64_t parse_url_delim_mask_avx2( const char* block, size_t len )
+{
+	const __m256i colon   = _mm256_set1_epi8( ':' );
+	const __m256i slash   = _mm256_set1_epi8( '/' );
+	const __m256i at      = _mm256_set1_epi8( '@' );
+	const __m256i quest   = _mm256_set1_epi8( '?' );
+	const __m256i hash    = _mm256_set1_epi8( '#' );
+	const __m256i lbrack  = _mm256_set1_epi8( '[' );
+	const __m256i rbrack  = _mm256_set1_epi8( ']' );
+	const __m256i percent = _mm256_set1_epi8( '%' );
+
+	uint64_t mask = 0;
+	size_t   i    = 0;
+	for( ; i + 32 <= len; i += 32 )
+	{
+		__m256i v = _mm256_loadu_si256( (const __m256i*)( block + i ) );
+		__m256i m = _mm256_or_si256( _mm256_or_si256( _mm256_or_si256( _mm256_cmpeq_epi8( v, colon  ), _mm256_cmpeq_epi8( v, slash   ) ),
+													  _mm256_or_si256( _mm256_cmpeq_epi8( v, at     ), _mm256_cmpeq_epi8( v, quest   ) ) ),
+									 _mm256_or_si256( _mm256_or_si256( _mm256_cmpeq_epi8( v, hash   ), _mm256_cmpeq_epi8( v, lbrack  ) ),
+													  _mm256_or_si256( _mm256_cmpeq_epi8( v, rbrack ), _mm256_cmpeq_epi8( v, percent ) ) ) );
+		mask |= (uint64_t)(unsigned int)_mm256_movemask_epi8( m ) << i;
+	}
+	if( i + 16 <= len )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i*)( block + i ) );
+		__m128i m = _mm_or_si128( _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( v, _mm256_castsi256_si128( colon  ) ), _mm_cmpeq_epi8( v, _mm256_castsi256_si128( slash   ) ) ),
+												_mm_or_si128( _mm_cmpeq_epi8( v, _mm256_castsi256_si128( at     ) ), _mm_cmpeq_epi8( v, _mm256_castsi256_si128( quest   ) ) ) ),
+								  _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( v, _mm256_castsi256_si128( hash   ) ), _mm_cmpeq_epi8( v, _mm256_castsi256_si128( lbrack  ) ) ),
+												_mm_or_si128( _mm_cmpeq_epi8( v, _mm256_castsi256_si128( rbrack ) ), _mm_cmpeq_epi8( v, _mm256_castsi256_si128( percent ) ) ) ) );
+		mask |= (uint64_t)(unsigned int)_mm_movemask_epi8( m ) << i;
+		i += 16;
+	}
+	return mask | parse_url_delim_mask_scalar_range( block, i, len );
+}
+
+static bool parse_url_cpu_has_sse2()
+{
+#if defined(_MSC_VER)
+	int regs[4];
+	__cpuid( regs, 1 );
+	return ( regs[3] & ( 1 << 26 ) ) != 0;
+#else
+	return __builtin_cpu_supports( "sse2" ) != 0;
+#endif
+}
+
+static bool parse_url_cpu_has_avx2()
+{
+#if defined(_MSC_VER)
+	int regs[4];
+	__cpuid( regs, 0 );
+	if( regs[0] < 7 )
+		return false;
+	__cpuid( regs, 1 );
+	// ... the os need to save the ymm-registers as well (OSXSAVE + XCR0 bit 1 and 2) ...
+	if( ( regs[2] & ( 1 << 27 ) ) == 0 || ( _xgetbv( 0 ) & 6 ) != 6 )
+		return false;
+	__cpuidex( regs, 7, 0 );
+	return ( regs[1] & ( 1 << 5 ) ) != 0;
+#else
+	return __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+}
+#endif // defined(URL_PARSER_X86_SIMD)
+
+static parse_url_delim_mask_func parse_url_select_delim_mask_kernel()
+{
+#if defined(URL_PARSER_X86_SIMD)
+	if( parse_url_cpu_has_avx2() )
+		return parse_url_delim_mask_avx2;
+	if( parse_url_cpu_has_sse2() )
+		return parse_url_delim_mask_sse2;
+#endif
+	return parse_url_delim_mask_scalar;
+}
+
+/**
+ * Return the fastest delimiter kernel supported by the cpu we are running on.
+ */
+static parse_url_delim_mask_func parse_url_delim_mask_kernel()
+{
+	static const parse_url_delim_mask_func kernel = parse_url_select_delim_mask_kernel();
+	return kernel;
+}
+
+/**
+ * Close the component that was being scanned when the end of the url was reached at end.
+ */
+static bool parse_url_scan_finish( parse_url_scanner* s, size_t end )
+{
+	parsed_url_view* out = s->out;
+
+	switch( s->state )
+	{
+		case PARSE_URL_SCAN_AUTHORITY:
+			return parse_url_scan_end_authority( s, end );
+		case PARSE_URL_SCAN_PATH:
+			out->path   = parse_url_make_range( s->comp_start, end );
+			out->flags |= PARSED_URL_VIEW_HAS_PATH;
+			break;
+		case PARSE_URL_SCAN_QUERY:
+			out->query  = parse_url_make_range( s->comp_start, end );
+			out->flags |= PARSED_URL_VIEW_HAS_QUERY;
+			break;
+		case PARSE_URL_SCAN_FRAGMENT:
+			out->fragment = parse_url_make_range( s->comp_start, end );
+			out->flags   |= PARSED_URL_VIEW_HAS_FRAGMENT;
+			break;
+	}
+	return true;
+}
+
+/**
+ * Continue the scan in s from i up to end, delimiters are found 64 bytes at a time with delim_mask.
+ * Delimiters that need to look ahead will look at most 2 bytes past end, but never past s->len.
+ *
+ * @return position to continue the scan at, this might be past end if the last delimiter consumed
+ *         more chars, or PARSE_URL_NPOS if the url is invalid.
+ */
+static size_t parse_url_scan_range( parse_url_scanner* s, size_t i, size_t end, parse_url_delim_mask_func delim_mask )
+{
+	const char* url = s->url;
+
+	while( i < end )
+	{
+		if( s->state == PARSE_URL_SCAN_FRAGMENT )
+			return end;
+
+		if( s->state == PARSE_URL_SCAN_QUERY )
+		{
+			// ... only '#' is left to find, let the c-runtime do that as fast as it can ...
+			const char* fragment = (const char*)memchr( url + i, '#', end - i );
+			if( fragment == 0x0 )
+				return end;
+			i = parse_url_scan_delim( s, (size_t)( fragment - url ) );
+			continue;
+		}
+
+		size_t   block     = i;
+		size_t   block_end = end - block < 64 ? end : block + 64;
+		uint64_t mask      = delim_mask( url + block, block_end - block );
+
+		i = block_end;
+		while( mask )
+		{
+			size_t pos = block + parse_url_count_trailing_zeros( mask );
+			mask &= mask - 1;
+
+			// ... only chars that are delimiters in the current state need to be looked at ...
+			if( ( parse_url_char_class[(unsigned char)url[pos]] & s->interest ) == 0 )
+				continue;
+
+			size_t next = parse_url_scan_delim( s, pos );
+			if( next == PARSE_URL_NPOS )
+				return PARSE_URL_NPOS;
+
+			if( next >= block_end || s->state >= PARSE_URL_SCAN_QUERY )
+			{
+				i = next;
+				break;
+			}
+
+			// ... skip delimiters that was consumed by the last one, i.e. "//" after scheme or "%xx" ...
+			mask &= ~( ( (uint64_t)1 << ( next - block ) ) - 1 );
+		}
+	}
+	return i;
+}
+
+/**
+ * Scan len bytes of url and fill out with the component boundaries.
+ */
+static bool parse_url_scan_url( const char* url, size_t len, parsed_url_view* out, parse_url_delim_mask_func delim_mask )
+{
+	memset(out, 0x0, sizeof(parsed_url_view));
+	out->url = url;
+
+	parse_url_scanner scan;
+	parse_url_scan_init( &scan, out, len );
+
+	if( parse_url_scan_range( &scan, 0, len, delim_mask ) == PARSE_URL_NPOS )
+		return false;
+
+	return parse_url_scan_finish( &scan, len );
+}
+
+struct parse_url_query_index
+{
+	const parsed_url_query_param* params;
+	unsigned int*                 slots;     // index + 1 into params, 0 for empty slots
+	size_t                        slot_mask; // number of slots - 1, always a power of 2
+};
+
+/**
+ * FNV-1a of key, used to place keys in parse_url_query_index.
+ */
+static unsigned int parse_url_hash_key( const char* key, size_t len )
+{
+	unsigned int hash = 2166136261u;
+	for( size_t i = 0; i < len; ++i )
+		hash = ( hash ^ (unsigned char)key[i] ) * 16777619u;
+	return hash;
+}
+
+static size_t parse_url_hash_num_slots( size_t num_params )
+{
+	// ... keep at least half the slots empty to keep the probe-sequences short ...
+	size_t num_slots = 4;
+	while( num_slots < num_params * 2 )
+		num_slots <<= 1;
+	return num_slots;
+}
+
+static parse_url_query_index* parse_url_alloc_query_index( parse_url_ctx* ctx, const parsed_url_query_param* params, size_t num_params )
+{
+	if( !parse_url_align_ctx( ctx ) )
+		return 0x0;
+
+	size_t num_slots = parse_url_hash_num_slots( num_params );
+	parse_url_query_index* index = (parse_url_query_index*)parse_url_alloc_mem( ctx, sizeof( parse_url_query_index ) );
+	unsigned int*          slots = (unsigned int*)parse_url_alloc_mem( ctx, sizeof( unsigned int ) * num_slots );
+	if( index == 0x0 || slots == 0x0 )
+		return 0x0;
+
+	memset( slots, 0x0, sizeof( unsigned int ) * num_slots );
+	index->params    = params;
+	index->slots     = slots;
+	index->slot_mask = num_slots - 1;
+
+	// ... linear probing and inserting in order makes lookups find the first of duplicated keys ...
+	for( size_t i = 0; i < num_params; ++i )
+	{
+		size_t slot = parse_url_hash_key( params[i].key, params[i].key_len ) & index->slot_mask;
+		while( slots[slot] != 0 )
+			slot = ( slot + 1 ) & index->slot_mask;
+		slots[slot] = (unsigned int)( i + 1 );
+	}
+	return index;
+}
+
+static bool parse_url_alloc_components( const parsed_url_view* view, parse_url_ctx* ctx, parsed_url* out, unsigned int flags )
+{
+	const char* url = view->url;
+
+	out->port      = view->port;
+	out->scheme_id = view->scheme_id;
+	out->host_type = view->host_type;
+	out->ipv4      = view->ipv4;
+	memcpy( out->ipv6, view->ipv6, sizeof( out->ipv6 ) );
+
+	if( view->flags & PARSED_URL_VIEW_HAS_PORT )
+		out->flags |= PARSED_URL_PORT_EXPLICIT;
+
+	if( view->flags & PARSED_URL_VIEW_HAS_SCHEME )
+	{
+		out->scheme = parse_url_alloc_lower_string( ctx, url + view->scheme.offset, view->scheme.length );
+		if( out->scheme == 0x0 )
+			return false;
+	}
+
+	if( view->flags & PARSED_URL_VIEW_HAS_USER )
+	{
+		out->user = parse_url_alloc_string( ctx, url + view->user.offset, view->user.length );
+		out->pass = "";
+		if( view->flags & PARSED_URL_VIEW_HAS_PASS )
+			out->pass = parse_url_alloc_string( ctx, url + view->pass.offset, view->pass.length );
+		if( out->user == 0x0 || out->pass == 0x0 )
+			return false;
+	}
+
+	if( view->flags & PARSED_URL_VIEW_HAS_HOST )
+	{
+		out->host = parse_url_alloc_lower_string( ctx, url + view->host.offset, view->host.length );
+		if( out->host == 0x0 )
+			return false;
+	}
+
+	if( view->flags & PARSED_URL_VIEW_HAS_PATH )
+	{
+		// ... most paths has no '%' and can just be copied ...
+		if( ( view->flags & PARSED_URL_VIEW_PATH_ENCODED ) == 0 )
+			out->path = parse_url_alloc_string( ctx, url + view->path.offset, view->path.length );
+		else if( flags & PARSE_URL_FLAG_LAZY_DECODE )
+		{
+			out->path   = parse_url_alloc_string( ctx, url + view->path.offset, view->path.length );
+			out->flags |= PARSED_URL_PATH_ENCODED;
+		}
+		else
+			out->path = parse_url_alloc_decoded_string( ctx, url + view->path.offset, view->path.length );
+		if( out->path == 0x0 )
+			return false;
+
+		if( flags & ( PARSE_URL_FLAG_NORMALIZE_PATH | PARSE_URL_FLAG_COLLAPSE_SLASHES ) )
+		{
+			unsigned int norm_flags = 0;
+			if( flags & PARSE_URL_FLAG_NORMALIZE_PATH )   norm_flags |= PARSE_URL_NORMALIZE_DOT_SEGMENTS | PARSE_URL_NORMALIZE_ESCAPES;
+			if( flags & PARSE_URL_FLAG_COLLAPSE_SLASHES ) norm_flags |= PARSE_URL_NORMALIZE_COLLAPSE_SLASHES;
+			parse_url_normalize( out, norm_flags );
+		}
+	}
+
+	if( view->flags & PARSED_URL_VIEW_HAS_QUERY )
+	{
+		out->query = parse_url_alloc_string( ctx, url + view->query.offset, view->query.length );
+		if( out->query == 0x0 )
+			return false;
+
+		if( flags & ( PARSE_URL_FLAG_QUERY_PARAMS | PARSE_URL_FLAG_QUERY_INDEX ) )
+		{
+			size_t num_params = parse_url_query_split( out->query, view->query.length, 0x0, 0 );
+			if( !parse_url_align_ctx( ctx ) )
+				return false;
+			parsed_url_query_param* params = (parsed_url_query_param*)parse_url_alloc_mem( ctx, sizeof( parsed_url_query_param ) * num_params );
+			if( params == 0x0 )
+				return false;
+			parse_url_query_split( out->query, view->query.length, params, num_params );
+			out->query_params     = params;
+			out->num_query_params = num_params;
+
+			if( flags & PARSE_URL_FLAG_QUERY_INDEX )
+			{
+				out->query_index = parse_url_alloc_query_index( ctx, params, num_params );
+				if( out->query_index == 0x0 )
+					return false;
+			}
+		}
+	}
+
+	if( view->flags & PARSED_URL_VIEW_HAS_FRAGMENT )
+	{
+		out->fragment = parse_url_alloc_string( ctx, url + view->fragment.offset, view->fragment.length );
+		if( out->fragment == 0x0 )
+			return false;
+	}
+
+	return true;
+}
+
+static parsed_url* parse_url_from_view_ctx( const parsed_url_view* view, parse_url_ctx* ctx, unsigned int flags )
+{
+	parsed_url* out = (parsed_url*)parse_url_alloc_mem( ctx, sizeof( parsed_url ) );
+	if( out == 0x0 )
+		return 0x0;
+
+	// ... set default values ...
+	memset(out, 0x0, sizeof(parsed_url));
+	out->host = "localhost";
+	out->path = "/";
+
+	if( !parse_url_alloc_components( view, ctx, out, flags ) )
+		return 0x0;
+	return out;
+}
+
+#define URL_PARSE_FAIL_IF( x )      \
+	if( x )                         \
+	{                               \
+		if( usermem == 0x0 )        \
+			URL_PARSER_FREE( mem ); \
+		return 0x0;                 \
+	}
+
+URL_PARSER_LINKAGE size_t parse_url_calc_mem_usage_n( const char* url, size_t url_len, unsigned int flags )
+{
+	size_t size = sizeof( parsed_url ) + url_len + 7; // 7 == max number of '\0' terminate
+
+	if( flags & ( PARSE_URL_FLAG_QUERY_PARAMS | PARSE_URL_FLAG_QUERY_INDEX ) )
+	{
+		// ... there can't be more params than '&' + 1, count in the entire url to not have to parse it here ...
+		size_t max_params = 1;
+		for( const char* amp = url, *end = url + url_len; ( amp = (const char*)memchr( amp, '&', (size_t)( end - amp ) ) ) != 0x0; ++amp )
+			++max_params;
+		size += PARSE_URL_ALIGNMENT - 1 + sizeof( parsed_url_query_param ) * max_params;
+
+		if( flags & PARSE_URL_FLAG_QUERY_INDEX )
+			size += parse_url_query_index_calc_mem_usage( max_params );
+	}
+	return size;
+}
+
+URL_PARSER_LINKAGE size_t parse_url_calc_mem_usage( const char* url, unsigned int flags )
+{
+	return parse_url_calc_mem_usage_n( url, strlen( url ), flags );
+}
+
+URL_PARSER_LINKAGE bool parse_url_view_n( const char* url, size_t url_len, parsed_url_view* out )
+{
+	return parse_url_scan_url( url, url_len, out, parse_url_delim_mask_kernel() );
+}
+
+URL_PARSER_LINKAGE bool parse_url_view( const char* url, parsed_url_view* out )
+{
+	return parse_url_view_n( url, strlen( url ), out );
+}
+
+URL_PARSER_LINKAGE const char* parse_url_view_copy_lower( const parsed_url_view* view, parsed_url_range range, char* dst, size_t dst_size )
+{
+	parse_url_ctx ctx = { dst, dst_size, dst_size };
+	return parse_url_alloc_lower_string( &ctx, view->url + range.offset, range.length );
+}
+
+URL_PARSER_LINKAGE const char* parse_url_view_decode( const parsed_url_view* view, parsed_url_range range, char* dst, size_t dst_size )
+{
+	parse_url_ctx ctx = { dst, dst_size, dst_size };
+	return parse_url_alloc_decoded_string( &ctx, view->url + range.offset, range.length );
+}
+
+URL_PARSER_LINKAGE size_t parse_url_view_calc_mem_usage( const parsed_url_view* view, unsigned int flags )
+{
+	// ... same order and sizes as parse_url_alloc_components(), all strings are allocated with their '\0' ...
+	size_t size = sizeof( parsed_url );
+	if( view->flags & PARSED_URL_VIEW_HAS_SCHEME )
+		size += view->scheme.length + 1;
+	if( view->flags & PARSED_URL_VIEW_HAS_USER )
+	{
+		size += view->user.length + 1;
+		if( view->flags & PARSED_URL_VIEW_HAS_PASS )
+			size += view->pass.length + 1;
+	}
+	if( view->flags & PARSED_URL_VIEW_HAS_HOST )
+		size += view->host.length + 1;
+	if( view->flags & PARSED_URL_VIEW_HAS_PATH )
+		size += view->path.length + 1;
+	if( view->flags & PARSED_URL_VIEW_HAS_QUERY )
+	{
+		size += view->query.length + 1;
+		if( flags & ( PARSE_URL_FLAG_QUERY_PARAMS | PARSE_URL_FLAG_QUERY_INDEX ) )
+		{
+			size_t num_params = parse_url_query_split( view->url + view->query.offset, view->query.length, 0x0, 0 );
+			size = parse_url_align_up( size ) + sizeof( parsed_url_query_param ) * num_params;
+			if( flags & PARSE_URL_FLAG_QUERY_INDEX )
+				size = parse_url_align_up( size ) + sizeof( parse_url_query_index ) + sizeof( unsigned int ) * parse_url_hash_num_slots( num_params );
+		}
+	}
+	if( view->flags & PARSED_URL_VIEW_HAS_FRAGMENT )
+		size += view->fragment.length + 1;
+	return size;
+}
+
+URL_PARSER_LINKAGE parsed_url* parse_url_from_view( const parsed_url_view* view, void* usermem, size_t mem_size, unsigned int flags )
+{
+	void* mem = usermem;
+	if( mem == 0x0 )
+	{
+		mem_size = parse_url_view_calc_mem_usage( view, flags );
+		mem = URL_PARSER_MALLOC( mem_size );
+	}
+
+	parse_url_ctx ctx = {mem, mem_size, mem_size};
+
+	parsed_url* out = parse_url_from_view_ctx( view, &ctx, flags );
+	URL_PARSE_FAIL_IF( out == 0x0 );
+
+	return out;
+}
+
+URL_PARSER_LINKAGE parsed_url* parse_url_n( const char* url, size_t url_len, void* usermem, size_t mem_size, unsigned int flags )
+{
+	parsed_url_view view;
+	if( !parse_url_view_n( url, url_len, &view ) )
+		return 0x0;
+	return parse_url_from_view( &view, usermem, mem_size, flags );
+}
+
+static void* parse_url_arena_default_alloc( size_t size, void* )
+{
+	return URL_PARSER_MALLOC( size );
+}
+
+static void parse_url_arena_default_free( void* ptr, void* )
+{
+	URL_PARSER_FREE( ptr );
+}
+
+// ... data of a chunk starts after the header, aligned ...
+static const size_t PARSE_URL_ARENA_HEADER_SIZE = ( sizeof( parse_url_arena_chunk ) + PARSE_URL_ALIGNMENT - 1 ) & ~( PARSE_URL_ALIGNMENT - 1 );
+
+URL_PARSER_LINKAGE void parse_url_arena_init( parse_url_arena* arena, size_t chunk_size, parse_url_arena_alloc_func alloc, parse_url_arena_free_func free_func, void* userdata )
+{
+	memset( arena, 0x0, sizeof( parse_url_arena ) );
+	arena->alloc_func = alloc     ? alloc     : parse_url_arena_default_alloc;
+	arena->free_func  = free_func ? free_func : parse_url_arena_default_free;
+	arena->userdata   = userdata;
+	arena->chunk_size = chunk_size;
+}
+
+URL_PARSER_LINKAGE void parse_url_arena_destroy( parse_url_arena* arena )
+{
+	parse_url_arena_chunk* chunk = arena->first;
+	while( chunk != 0x0 )
+	{
+		parse_url_arena_chunk* next = chunk->next;
+		arena->free_func( chunk, arena->userdata );
+		chunk = next;
+	}
+	arena->first     = 0x0;
+	arena->current   = 0x0;
+	arena->pos       = 0;
+	arena->used      = 0;
+	arena->allocated = 0;
+}
+
+URL_PARSER_LINKAGE void parse_url_arena_reset( parse_url_arena* arena )
+{
+	// ... only the position in the current chunk is stored, so all chunks are empty when starting over ...
+	arena->current = arena->first;
+	arena->pos     = PARSE_URL_ARENA_HEADER_SIZE;
+	arena->used    = 0;
+}
+
+URL_PARSER_LINKAGE void* parse_url_arena_alloc( parse_url_arena* arena, size_t size )
+{
+	size_t aligned_size = parse_url_align_up( size );
+	parse_url_arena_chunk* chunk = arena->current;
+	if( chunk == 0x0 || aligned_size > chunk->size - arena->pos )
+	{
+		// ... use the next chunk if it is big enough, otherwise place a new one before it ...
+		parse_url_arena_chunk* next = chunk ? chunk->next : arena->first;
+		if( next == 0x0 || aligned_size > next->size - PARSE_URL_ARENA_HEADER_SIZE )
+		{
+			size_t chunk_size = PARSE_URL_ARENA_HEADER_SIZE + aligned_size;
+			if( chunk_size < arena->chunk_size )
+				chunk_size = arena->chunk_size;
+
+			parse_url_arena_chunk* new_chunk = (parse_url_arena_chunk*)arena->alloc_func( chunk_size, arena->userdata );
+			if( new_chunk == 0x0 )
+				return 0x0;
+			new_chunk->next = next;
+			new_chunk->size = chunk_size;
+			if( chunk )
+				chunk->next = new_chunk;
+			else
+				arena->first = new_chunk;
+			arena->allocated += chunk_size;
+			next = new_chunk;
+		}
+
+		// ... what is left of the current chunk is not used until the next reset ...
+		if( chunk )
+			arena->used += chunk->size - arena->pos;
+		arena->current = next;
+		arena->pos     = PARSE_URL_ARENA_HEADER_SIZE;
+		chunk          = next;
+	}
+
+	void* res = (char*)chunk + arena->pos;
+	arena->pos  += aligned_size;
+	arena->used += aligned_size;
+	if( arena->used > arena->high_water )
+		arena->high_water = arena->used;
+	return res;
+}
+
+URL_PARSER_LINKAGE parsed_url* parse_url_arena_parse_n( parse_url_arena* arena, const char* url, size_t url_len, unsigned int flags )
+{
+	parsed_url_view view;
+	if( !parse_url_view_n( url, url_len, &view ) )
+		return 0x0;
+
+	size_t mem_size = parse_url_view_calc_mem_usage( &view, flags );
+	void*  mem      = parse_url_arena_alloc( arena, mem_size );
+	if( mem == 0x0 )
+		return 0x0;
+	return parse_url_from_view( &view, mem, mem_size, flags );
+}
+
+URL_PARSER_LINKAGE parsed_url* parse_url_arena_parse( parse_url_arena* arena, const char* url, unsigned int flags )
+{
+	return parse_url_arena_parse_n( arena, url, strlen( url ), flags );
+}
+
+URL_PARSER_LINKAGE parsed_url* parse_url( const char* url, void* usermem, size_t mem_size, unsigned int flags )
+{
+	return parse_url_n( url, strlen( url ), usermem, mem_size, flags );
+}
+
+URL_PARSER_LINKAGE const char* parse_url_decode_path( parsed_url* parsed )
+{
+	if( parsed->flags & PARSED_URL_PATH_ENCODED )
+	{
+		// ... the path is placed in memory owned by parsed and was validated during parse, decoding in place can't fail ...
+		char*  path = (char*)parsed->path;
+		size_t len  = parse_url_unescape_percent_encoding( path, path, strlen( path ) );
+		path[len] = '\0';
+		parsed->flags &= ~(unsigned int)PARSED_URL_PATH_ENCODED;
+	}
+	return parsed->path;
+}
+
+static bool parse_url_is_unreserved( char c )
+{
+	return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || ( c >= '0' && c <= '9' ) ||
+		   c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+/**
+ * Copy the segment src[0, len) to dst, dst might overlap src but is never after it.
+ * Normalize escapes while at it if PARSE_URL_NORMALIZE_ESCAPES is set.
+ */
+static size_t parse_url_normalize_copy_segment( char* dst, const char* src, size_t len, unsigned int flags )
+{
+	if( ( flags & PARSE_URL_NORMALIZE_ESCAPES ) == 0 )
+	{
+		if( dst != src )
+			memmove( dst, src, len );
+		return len;
+	}
+
+	static const char HEX[] = "0123456789ABCDEF";
+	size_t out = 0;
+	for( size_t in = 0; in < len; ++in )
+	{
+		char c = src[in];
+		if( c == '%' && in + 2 < len && parse_url_is_hex_char( src[in + 1] ) && parse_url_is_hex_char( src[in + 2] ) )
+		{
+			unsigned char value = (unsigned char)( ( parse_url_hex_value[(unsigned char)src[in + 1]] << 4 ) | parse_url_hex_value[(unsigned char)src[in + 2]] );
+			in += 2;
+			if( parse_url_is_unreserved( (char)value ) )
+				dst[out++] = (char)value;
+			else
+			{
+				dst[out++] = '%';
+				dst[out++] = HEX[value >> 4];
+				dst[out++] = HEX[value & 0xF];
+			}
+			continue;
+		}
+		dst[out++] = c;
+	}
+	return out;
+}
+
+URL_PARSER_LINKAGE size_t parse_url_normalize_path( char* path, size_t path_len, unsigned int flags )
+{
+	// ... the path is handled one segment at a time, a segment is copied to the output and then
+	//     dropped again if it turned out to be "." or "..". Output is always behind the input ...
+	size_t in  = 0;
+	size_t out = 0;
+	if( path_len > 0 && path[0] == '/' )
+		in = out = 1;
+
+	while( in <= path_len )
+	{
+		const char* slash   = (const char*)memchr( path + in, '/', path_len - in );
+		size_t      seg_end = slash == 0x0 ? path_len : (size_t)( slash - path );
+		bool        last    = slash == 0x0;
+
+		size_t seg_start = out;
+		out += parse_url_normalize_copy_segment( path + out, path + in, seg_end - in, flags );
+		size_t seg_len = out - seg_start;
+		in = seg_end + 1;
+
+		if( flags & PARSE_URL_NORMALIZE_DOT_SEGMENTS )
+		{
+			if( seg_len == 1 && path[seg_start] == '.' )
+			{
+				out = seg_start;
+				continue;
+			}
+
+			if( seg_len == 2 && path[seg_start] == '.' && path[seg_start + 1] == '.' )
+			{
+				// ... remove the segment before, but never the root '/' ...
+				out = seg_start;
+				if( out > 0 && !( out == 1 && path[0] == '/' ) )
+				{
+					--out;
+					while( out > 0 && path[out - 1] != '/' )
+						--out;
+
+					// ... RFC3986 turns "a/../b" into "/b" ...
+					if( out == 0 )
+						path[out++] = '/';
+				}
+				continue;
+			}
+		}
+
+		if( seg_len == 0 && ( flags & PARSE_URL_NORMALIZE_COLLAPSE_SLASHES ) && out > 0 && path[out - 1] == '/' )
+			continue;
+
+		if( !last )
+			path[out++] = '/';
+	}
+	return out;
+}
+
+URL_PARSER_LINKAGE const char* parse_url_normalize( parsed_url* parsed, unsigned int flags )
+{
+	if( ( parsed->flags & PARSED_URL_PATH_ENCODED ) == 0 )
+		flags &= ~(unsigned int)PARSE_URL_NORMALIZE_ESCAPES;
+
+	// ... the path is placed in memory owned by parsed, except for the default "/" that is already normalized ...
+	char*  path = (char*)parsed->path;
+	size_t len  = strlen( path );
+	size_t norm = parse_url_normalize_path( path, len, flags );
+	if( norm != len )
+		path[norm] = '\0';
+	return parsed->path;
+}
+
+/**
+ * Check that all '%' in the len first chars of str is followed by 2 hex-chars.
+ */
+static bool parse_url_percent_encoding_valid( const char* str, size_t len )
+{
+	for( const char* c = str, *end = str + len; ( c = (const char*)memchr( c, '%', (size_t)( end - c ) ) ) != 0x0; c += 3 )
+		if( end - c < 3 || !parse_url_is_hex_char( c[1] ) || !parse_url_is_hex_char( c[2] ) )
+			return false;
+	return true;
+}
+
+static const char* parse_url_copy_string( parse_url_ctx* ctx, const char* str )
+{
+	return str == 0x0 ? 0x0 : parse_url_alloc_string( ctx, str, strlen( str ) );
+}
+
+/**
+ * Copy str to *out, returns false if str was set but could not be copied.
+ */
+static bool parse_url_copy_base_string( parse_url_ctx* ctx, const char* str, const char** out )
+{
+	*out = parse_url_copy_string( ctx, str );
+	return str == 0x0 || *out != 0x0;
+}
+
+static parsed_url* parse_url_resolve_ctx( const parsed_url* base, const char* ref, size_t ref_len, parse_url_ctx* ctx )
+{
+	// ... split ref as in RFC3986 appendix B, scheme first ...
+	size_t i = 0;
+	if( ref_len > 0 && parse_url_ascii_lower( ref[0] ) >= 'a' && parse_url_ascii_lower( ref[0] ) <= 'z' )
+	{
+		size_t c = 1;
+		while( c < ref_len && ( ( parse_url_ascii_lower( ref[c] ) >= 'a' && parse_url_ascii_lower( ref[c] ) <= 'z' ) ||
+								( ref[c] >= '0' && ref[c] <= '9' ) || ref[c] == '+' || ref[c] == '-' || ref[c] == '.' ) )
+			++c;
+		if( c < ref_len && ref[c] == ':' )
+			i = c + 1;
+	}
+	size_t scheme_len = i == 0 ? 0 : i - 1;
+
+	bool   has_authority = ref_len - i >= 2 && ref[i] == '/' && ref[i + 1] == '/';
+	size_t auth_start    = i + 2;
+	if( has_authority )
+		for( i = auth_start; i < ref_len && ref[i] != '/' && ref[i] != '?' && ref[i] != '#'; ++i ) {}
+	size_t auth_end = i;
+
+	size_t path_start = i;
+	while( i < ref_len && ref[i] != '?' && ref[i] != '#' )
+		++i;
+	size_t path_len = i - path_start;
+
+	size_t query_start = PARSE_URL_NPOS;
+	if( i < ref_len && ref[i] == '?' )
+	{
+		query_start = ++i;
+		while( i < ref_len && ref[i] != '#' )
+			++i;
+	}
+	size_t query_len = i - query_start;
+	size_t fragment_start = i < ref_len ? i + 1 : PARSE_URL_NPOS;
+
+	if( !parse_url_percent_encoding_valid( ref + path_start, path_len ) )
+		return 0x0;
+
+	parsed_url* out = (parsed_url*)parse_url_alloc_mem( ctx, sizeof( parsed_url ) );
+	if( out == 0x0 )
+		return 0x0;
+	memset(out, 0x0, sizeof(parsed_url));
+	out->host = "localhost";
+	out->path = "/";
+
+	if( scheme_len > 0 || has_authority )
+	{
+		// ... the authority is taken from ref, let the scanner handle it ...
+		if( has_authority )
+		{
+			parsed_url_view auth;
+			if( !parse_url_scan_url( ref + auth_start, auth_end - auth_start, &auth, parse_url_delim_mask_kernel() ) )
+				return 0x0;
+			if( !parse_url_alloc_components( &auth, ctx, out, 0 ) )
+				return 0x0;
+		}
+
+		if( scheme_len > 0 )
+		{
+			out->scheme = parse_url_alloc_lower_string( ctx, ref, scheme_len );
+			if( out->scheme == 0x0 )
+				return 0x0;
+		}
+		else if( !parse_url_copy_base_string( ctx, base->scheme, &out->scheme ) )
+			return 0x0;
+
+		unsigned int default_port = 0;
+		out->scheme_id = out->scheme == 0x0 ? (unsigned int)PARSE_URL_SCHEME_NONE : parse_url_lookup_scheme( out->scheme, strlen( out->scheme ), &default_port );
+		if( ( out->flags & PARSED_URL_PORT_EXPLICIT ) == 0 )
+			out->port = default_port;
+	}
+	else
+	{
+		// ... same authority as base ...
+		if( !parse_url_copy_base_string( ctx, base->scheme, &out->scheme ) ||
+			!parse_url_copy_base_string( ctx, base->user,   &out->user ) ||
+			!parse_url_copy_base_string( ctx, base->pass,   &out->pass ) ||
+			!parse_url_copy_base_string( ctx, base->host,   &out->host ) || out->host == 0x0 )
+			return 0x0;
+		out->scheme_id = base->scheme_id;
+		out->port      = base->port;
+		out->host_type = base->host_type;
+		out->ipv4      = base->ipv4;
+		out->flags     = base->flags & PARSED_URL_PORT_EXPLICIT;
+		memcpy( out->ipv6, base->ipv6, sizeof( out->ipv6 ) );
+	}
+
+	if( scheme_len == 0 && !has_authority && path_len == 0 )
+	{
+		// ... only query and/or fragment, path and maybe query is kept from base ...
+		if( !parse_url_copy_base_string( ctx, base->path, &out->path ) || out->path == 0x0 )
+			return 0x0;
+		if( query_start == PARSE_URL_NPOS && !parse_url_copy_base_string( ctx, base->query, &out->query ) )
+			return 0x0;
+		out->flags |= base->flags & PARSED_URL_PATH_ENCODED;
+	}
+	else if( path_len > 0 )
+	{
+		// ... relative paths are merged with everything up until the last '/' of the path of base ...
+		size_t base_len = 0;
+		bool   merge    = scheme_len == 0 && !has_authority && ref[path_start] != '/';
+		if( merge )
+		{
+			const char* last_slash = strrchr( base->path, '/' );
+			base_len = last_slash == 0x0 ? 0 : (size_t)( last_slash - base->path ) + 1;
+		}
+
+		char* path = (char*)parse_url_alloc_mem( ctx, base_len + path_len + 1 );
+		if( path == 0x0 )
+			return 0x0;
+		memcpy( path, base->path, base_len );
+
+		// ... a base parsed with lazy decode has an encoded path, keep the result the same way, also when ref replaces the path ...
+		size_t len;
+		if( base->flags & PARSED_URL_PATH_ENCODED )
+		{
+			memcpy( path + base_len, ref + path_start, path_len );
+			len = base_len + path_len;
+		}
+		else
+			len = base_len + parse_url_unescape_percent_encoding( path + base_len, ref + path_start, path_len );
+
+		len = parse_url_normalize_path( path, len, PARSE_URL_NORMALIZE_DOT_SEGMENTS );
+		path[len] = '\0';
+		if( len > 0 )
+		{
+			out->path   = path;
+			out->flags |= base->flags & PARSED_URL_PATH_ENCODED;
+		}
+	}
+
+	if( query_start != PARSE_URL_NPOS )
+	{
+		out->query = parse_url_alloc_string( ctx, ref + query_start, query_len );
+		if( out->query == 0x0 )
+			return 0x0;
+	}
+
+	if( fragment_start != PARSE_URL_NPOS )
+	{
+		out->fragment = parse_url_alloc_string( ctx, ref + fragment_start, ref_len - fragment_start );
+		if( out->fragment == 0x0 )
+			return 0x0;
+	}
+
+	return out;
+}
+
+URL_PARSER_LINKAGE size_t parse_url_resolve_calc_mem_usage_n( const parsed_url* base, const char* ref, size_t ref_len )
+{
+	// ... worst case is all of base and ref, 8 == max number of '\0' terminate ...
+	(void)ref;
+	size_t size = sizeof( parsed_url ) + ref_len + 8;
+	const char* base_strings[] = { base->scheme, base->user, base->pass, base->host, base->path, base->query };
+	for( size_t i = 0; i < sizeof( base_strings ) / sizeof( base_strings[0] ); ++i )
+		if( base_strings[i] != 0x0 )
+			size += strlen( base_strings[i] );
+	return size;
+}
 
+URL_PARSER_LINKAGE size_t parse_url_resolve_calc_mem_usage( const parsed_url* base, const char* ref )
+{
+	return parse_url_resolve_calc_mem_usage_n( base, ref, strlen( ref ) );
+}
 
+URL_PARSER_LINKAGE parsed_url* parse_url_resolve_n( const parsed_url* base, const char* ref, size_t ref_len, void* usermem, size_t mem_size )
+{
+	void* mem = usermem;
+	if( mem == 0x0 )
+	{
+		mem_size = parse_url_resolve_calc_mem_usage_n( base, ref, ref_len );
+		mem = URL_PARSER_MALLOC( mem_size );
+	}
 
+	parse_url_ctx ctx = {mem, mem_size, mem_size};
 
-#if defined(URL_PARSER_IMPLEMENTATION)
-#include <ctype.h>
-#include <stdlib.h>
-#include <string.h>
+	parsed_url* out = parse_url_resolve_ctx( base, ref, ref_len, &ctx );
+	URL_PARSE_FAIL_IF( out == 0x0 );
 
-struct parse_url_ctx
-{
-	void* mem;
-	size_t memsize;
-	size_t memleft;
-};
+	return out;
+}
 
-const char* parse_url_strnchr( const char* str, size_t len, int ch )
+URL_PARSER_LINKAGE parsed_url* parse_url_resolve( const parsed_url* base, const char* ref, void* usermem, size_t mem_size )
 {
-	for( size_t i = 0; i < len; ++i )
-		if( str[i] == ch )
-			return &str[i];
-	return 0x0;
+	return parse_url_resolve_n( base, ref, strlen( ref ), usermem, mem_size );
 }
 
-static void* parse_url_alloc_mem( parse_url_ctx* ctx, size_t request_size )
+static void parse_url_pack_string( parsed_url_packed* out, uint32_t* offset, const char* str, parsed_url_packed_range* range )
 {
-	if( request_size > ctx->memleft )
-		return 0;
-	void* res = (char*)ctx->mem + ctx->memsize - ctx->memleft;
-	ctx->memleft -= request_size;
-	return res;
+	if( str == 0x0 )
+		return;
+	size_t len = strlen( str );
+	range->offset = *offset;
+	range->length = (uint32_t)len;
+	memcpy( (char*)out + *offset, str, len + 1 );
+	*offset += (uint32_t)len + 1;
 }
 
-static unsigned int parse_url_default_port_for_scheme( const char* scheme )
+URL_PARSER_LINKAGE size_t parse_url_pack_calc_mem_usage( const parsed_url* parsed )
 {
-	if( scheme == 0x0 )
-		return 0;
+	const char* strs[] = { parsed->scheme, parsed->user, parsed->pass, parsed->host, parsed->path, parsed->query, parsed->fragment };
 
-	if( strcmp( scheme, "http"   ) == 0 ) return 80;
-	if( strcmp( scheme, "https"  ) == 0 ) return 443;
-	if( strcmp( scheme, "ftp"    ) == 0 ) return 21;
-	if( strcmp( scheme, "ssh"    ) == 0 ) return 22;
-	if( strcmp( scheme, "telnet" ) == 0 ) return 23;
-	return 0x0;
+	size_t size = sizeof( parsed_url_packed );
+	for( size_t i = 0; i < sizeof( strs ) / sizeof( strs[0] ); ++i )
+		if( strs[i] != 0x0 )
+			size += strlen( strs[i] ) + 1;
+	return size;
 }
 
-static char* parse_url_alloc_string( parse_url_ctx* ctx, const char* src, size_t len)
+URL_PARSER_LINKAGE parsed_url_packed* parse_url_pack( const parsed_url* parsed, void* usermem, size_t mem_size )
 {
-	char* dst = (char*)parse_url_alloc_mem( ctx, len + 1 );
-	if( dst == 0x0 )
+	size_t size = parse_url_pack_calc_mem_usage( parsed );
+	if( size > 0xFFFFFFFF )
 		return 0x0;
-	memcpy( dst, src, len );
-	dst[len] = '\0';
-	return dst;
+
+	void* mem = usermem;
+	if( mem == 0x0 )
+	{
+		mem_size = size;
+		mem = URL_PARSER_MALLOC( mem_size );
+		if( mem == 0x0 )
+			return 0x0;
+	}
+	URL_PARSE_FAIL_IF( mem_size < size );
+
+	parsed_url_packed* out = (parsed_url_packed*)mem;
+	memset( out, 0x0, sizeof( parsed_url_packed ) );
+	out->size      = (uint32_t)size;
+	out->flags     = parsed->flags;
+	out->port      = parsed->port;
+	out->scheme_id = parsed->scheme_id;
+	out->host_type = parsed->host_type;
+	out->ipv4      = parsed->ipv4;
+	memcpy( out->ipv6, parsed->ipv6, sizeof( out->ipv6 ) );
+
+	// ... strings are stored in the same order as the components, after the header ...
+	uint32_t offset = (uint32_t)sizeof( parsed_url_packed );
+	parse_url_pack_string( out, &offset, parsed->scheme,   &out->scheme );
+	parse_url_pack_string( out, &offset, parsed->user,     &out->user );
+	parse_url_pack_string( out, &offset, parsed->pass,     &out->pass );
+	parse_url_pack_string( out, &offset, parsed->host,     &out->host );
+	parse_url_pack_string( out, &offset, parsed->path,     &out->path );
+	parse_url_pack_string( out, &offset, parsed->query,    &out->query );
+	parse_url_pack_string( out, &offset, parsed->fragment, &out->fragment );
+	return out;
 }
 
-static const char* parse_url_alloc_lower_string( parse_url_ctx* ctx, const char* src, size_t len)
+URL_PARSER_LINKAGE const parsed_url_packed* parse_url_packed_check( const void* mem, size_t mem_size )
 {
-	char* dst = (char*)parse_url_alloc_mem( ctx, len + 1 );
-	if( dst == 0x0 )
+	if( mem_size < sizeof( parsed_url_packed ) )
 		return 0x0;
-	// parse_url_strncpy_lower( new_str, src, len );
-	for( size_t i = 0; i < len; ++i )
-		dst[i] = (char)tolower( src[i] );
-	dst[len] = '\0';
-	return dst;
-}
 
-static const char* parse_url_parse_scheme( const char* url, parse_url_ctx* ctx, parsed_url* out )
-{
-	const char* schemesep = strchr( url, ':' );
-	if( schemesep == 0x0 )
-		return url;
-	else
+	const parsed_url_packed* packed = (const parsed_url_packed*)mem;
+	if( packed->size < sizeof( parsed_url_packed ) || packed->size > mem_size )
+		return 0x0;
+
+	const parsed_url_packed_range ranges[] = { packed->scheme, packed->user, packed->pass, packed->host, packed->path, packed->query, packed->fragment };
+	for( size_t i = 0; i < sizeof( ranges ) / sizeof( ranges[0] ); ++i )
 	{
-		// ... is this the user part of a user/pass pair or the separator host:port? ...
-		if( schemesep[1] != '/')
-			return url;
+		parsed_url_packed_range range = ranges[i];
+		if( range.offset == 0 )
+		{
+			if( range.length != 0 )
+				return 0x0;
+			continue;
+		}
 
-		if( schemesep[2] != '/' )
+		// ... 64 bit to not overflow, the '\0' need to be within size as well ...
+		if( range.offset < sizeof( parsed_url_packed ) || (uint64_t)range.offset + range.length >= packed->size )
 			return 0x0;
-
-		out->scheme = parse_url_alloc_lower_string( ctx, url, (size_t)( schemesep - url ) );
-		if(out->scheme == 0x0)
+		if( ( (const char*)mem )[range.offset + range.length] != '\0' )
 			return 0x0;
-		return &schemesep[3];
 	}
+	return packed;
+}
+
+URL_PARSER_LINKAGE void parse_url_string_pool_init( parse_url_string_pool* pool, void* mem, size_t mem_size )
+{
+	pool->mem  = (char*)mem;
+	pool->size = mem_size;
+	pool->used = 0;
+}
+
+/**
+ * Fill strs and lens with the components of parsed and return the amount of pool they need.
+ */
+static size_t parse_url_compact_components( const parsed_url* parsed, const char** strs, size_t* lens, bool* is_long )
+{
+	strs[PARSE_URL_COMPONENT_SCHEME]   = parsed->scheme;
+	strs[PARSE_URL_COMPONENT_USER]     = parsed->user;
+	strs[PARSE_URL_COMPONENT_PASS]     = parsed->pass;
+	strs[PARSE_URL_COMPONENT_HOST]     = parsed->host;
+	strs[PARSE_URL_COMPONENT_PATH]     = parsed->path;
+	strs[PARSE_URL_COMPONENT_QUERY]    = parsed->query;
+	strs[PARSE_URL_COMPONENT_FRAGMENT] = parsed->fragment;
+
+	size_t size = 0;
+	*is_long = false;
+	for( size_t i = 0; i < PARSE_URL_COMPONENT_COUNT; ++i )
+	{
+		lens[i] = strs[i] == 0x0 ? 0 : strlen( strs[i] );
+		size += lens[i];
+		if( lens[i] >= 0xFFFF )
+			*is_long = true;
+	}
+	return *is_long ? size + sizeof( uint32_t ) * PARSE_URL_COMPONENT_COUNT : size;
 }
 
-static const char* parse_url_parse_user_pass( const char* url, parse_url_ctx* ctx, parsed_url* out )
+URL_PARSER_LINKAGE size_t parse_url_compact_pool_usage( const parsed_url* parsed )
 {
-	const char* atpos = strchr( url, '@' );
-	if( atpos != 0x0 )
+	const char* strs[PARSE_URL_COMPONENT_COUNT];
+	size_t      lens[PARSE_URL_COMPONENT_COUNT];
+	bool        is_long;
+	return parse_url_compact_components( parsed, strs, lens, &is_long );
+}
+
+URL_PARSER_LINKAGE bool parse_url_compact( const parsed_url* parsed, parse_url_string_pool* pool, parsed_url_compact* out )
+{
+	const char* strs[PARSE_URL_COMPONENT_COUNT];
+	size_t      lens[PARSE_URL_COMPONENT_COUNT];
+	bool        is_long;
+	size_t      size = parse_url_compact_components( parsed, strs, lens, &is_long );
+	if( size > pool->size - pool->used || pool->used > 0xFFFFFFFF || parsed->scheme_id > 0xFFFF || parsed->port > 0xFFFF )
+		return false;
+
+	out->pool_offset = (uint32_t)pool->used;
+	out->port        = (uint16_t)parsed->port;
+	out->scheme_id   = (uint16_t)parsed->scheme_id;
+	out->host_type   = (uint8_t)parsed->host_type;
+	out->flags       = (uint8_t)( ( ( parsed->flags & PARSED_URL_PATH_ENCODED )  ? PARSED_URL_COMPACT_PATH_ENCODED  : 0 ) |
+								  ( ( parsed->flags & PARSED_URL_PORT_EXPLICIT ) ? PARSED_URL_COMPACT_PORT_EXPLICIT : 0 ) |
+								  ( is_long ? PARSED_URL_COMPACT_LONG : 0 ) );
+
+	char* dst = pool->mem + pool->used;
+	for( size_t i = 0; i < PARSE_URL_COMPONENT_COUNT; ++i )
 	{
-		// ... check for a : before the @ ...
-		const char* passsep = parse_url_strnchr( url, (size_t)( atpos - url ), ':' );
-		if( passsep == 0 )
+		if( is_long )
 		{
-			out->pass = "";
-			out->user = parse_url_alloc_string( ctx, url, (size_t)( atpos - url ) );
+			// ... the pool has no alignment, so the lengths are copied byte by byte ...
+			uint32_t len = strs[i] == 0x0 ? 0xFFFFFFFF : (uint32_t)lens[i];
+			memcpy( dst + sizeof( uint32_t ) * i, &len, sizeof( uint32_t ) );
+			out->lengths[i] = 0;
 		}
 		else
-		{
-			size_t userlen = (size_t)(passsep - url);
-			size_t passlen = (size_t)(atpos - passsep - 1);
-			out->user = (char*)parse_url_alloc_string( ctx, url, userlen );
-			out->pass = (char*)parse_url_alloc_string( ctx, passsep + 1, passlen );
-		}
+			out->lengths[i] = strs[i] == 0x0 ? (uint16_t)0xFFFF : (uint16_t)lens[i];
+	}
+	if( is_long )
+		dst += sizeof( uint32_t ) * PARSE_URL_COMPONENT_COUNT;
 
-		if(out->user == 0x0 || out->pass == 0x0)
-			return 0x0;
+	for( size_t i = 0; i < PARSE_URL_COMPONENT_COUNT; ++i )
+	{
+		if( strs[i] == 0x0 )
+			continue;
+		memcpy( dst, strs[i], lens[i] );
+		dst += lens[i];
+	}
+	pool->used += size;
+	return true;
+}
 
-		return atpos + 1;
+URL_PARSER_LINKAGE const char* parsed_url_compact_get( const parsed_url_compact* compact, const parse_url_string_pool* pool, unsigned int component, size_t* len )
+{
+	const char* str = pool->mem + compact->pool_offset;
+	if( compact->flags & PARSED_URL_COMPACT_LONG )
+	{
+		uint32_t lens[PARSE_URL_COMPONENT_COUNT];
+		memcpy( lens, str, sizeof( lens ) );
+		str += sizeof( lens );
+
+		// ... offset is the sum of the lengths of all components before this one ...
+		for( unsigned int i = 0; i < component; ++i )
+			str += lens[i] == 0xFFFFFFFF ? 0 : lens[i];
+		*len = lens[component] == 0xFFFFFFFF ? 0 : lens[component];
+		return lens[component] == 0xFFFFFFFF ? 0x0 : str;
 	}
 
-	return url;
+	for( unsigned int i = 0; i < component; ++i )
+		str += compact->lengths[i] == 0xFFFF ? 0 : compact->lengths[i];
+	*len = compact->lengths[component] == 0xFFFF ? 0 : compact->lengths[component];
+	return compact->lengths[component] == 0xFFFF ? 0x0 : str;
 }
 
-static bool parse_url_is_hex_char( char c )
+URL_PARSER_LINKAGE void parse_url_query_iter_init( parse_url_query_iter* it, const char* query, size_t query_len )
 {
-	return (c >= 'a' && c <= 'f') ||
-		   (c >= 'A' && c <= 'F') ||
-		   (c >= '0' && c <= '9');
+	it->pos = query;
+	it->end = query + query_len;
 }
 
-static char parse_url_hex_char_value( char c )
+URL_PARSER_LINKAGE bool parse_url_query_next( parse_url_query_iter* it, parsed_url_query_param* param )
 {
-	if(c >= '0' && c <= '9') return c - '0';
-	if(c >= 'a' && c <= 'f') return c - 'a' + 10;
-	if(c >= 'A' && c <= 'F') return c - 'A' + 10;
-	return 0;
+	while( it->pos < it->end )
+	{
+		const char* start = it->pos;
+		const char* amp   = (const char*)memchr( start, '&', (size_t)( it->end - start ) );
+		const char* stop  = amp ? amp : it->end;
+		it->pos = amp ? amp + 1 : it->end;
+
+		if( stop == start )
+			continue;
+
+		const char* eq = (const char*)memchr( start, '=', (size_t)( stop - start ) );
+		param->key       = start;
+		param->key_len   = (size_t)( ( eq ? eq : stop ) - start );
+		param->value     = eq ? eq + 1 : 0x0;
+		param->value_len = eq ? (size_t)( stop - eq - 1 ) : 0;
+		return true;
+	}
+	return false;
 }
 
-static char* parse_url_unescape_percent_encoding( char* str )
+URL_PARSER_LINKAGE size_t parse_url_query_split( const char* query, size_t query_len, parsed_url_query_param* params, size_t max_params )
 {
-	char* read  = str;
-	char* write = str;
+	parse_url_query_iter it;
+	parse_url_query_iter_init( &it, query, query_len );
 
-	while(*read)
+	size_t num_params = 0;
+	parsed_url_query_param param;
+	while( parse_url_query_next( &it, &param ) )
 	{
-		if(*read == '%')
-		{
-			++read;
-			if(!parse_url_is_hex_char(*read))
-				return 0x0;
-			char v1 = parse_url_hex_char_value(*read); 
+		if( num_params < max_params )
+			params[num_params] = param;
+		++num_params;
+	}
+	return num_params;
+}
 
-			++read;
-			if(!parse_url_is_hex_char(*read))
-				return 0x0;
+URL_PARSER_LINKAGE void parse_url_path_iter_init( parse_url_path_iter* it, const char* path, size_t path_len )
+{
+	it->pos = path;
+	it->end = path + path_len;
+}
 
-			char v2 = parse_url_hex_char_value(*read);
+URL_PARSER_LINKAGE bool parse_url_path_next( parse_url_path_iter* it, parsed_url_path_segment* segment )
+{
+	while( it->pos < it->end )
+	{
+		const char* start = it->pos;
+		const char* slash = (const char*)memchr( start, '/', (size_t)( it->end - start ) );
+		const char* stop  = slash ? slash : it->end;
+		it->pos = slash ? slash + 1 : it->end;
 
-			*write = (char)((v1 << 4) | v2);
-		}
-		else
-		{
-			*write = *read;
-		}
-		++read;
-		++write;
+		if( stop == start )
+			continue;
+
+		segment->str = start;
+		segment->len = (size_t)( stop - start );
+		return true;
 	}
-	*write = '\0';
-	return str;
+	return false;
 }
 
-static const char* parse_url_parse_host_port( const char* url, parse_url_ctx* ctx, parsed_url* out )
+URL_PARSER_LINKAGE size_t parse_url_path_split( const char* path, size_t path_len, parsed_url_path_segment* segments, size_t max_segments )
 {
-	out->port = parse_url_default_port_for_scheme( out->scheme );
+	parse_url_path_iter it;
+	parse_url_path_iter_init( &it, path, path_len );
+
+	size_t num_segments = 0;
+	parsed_url_path_segment segment;
+	while( parse_url_path_next( &it, &segment ) )
+	{
+		if( num_segments < max_segments )
+			segments[num_segments] = segment;
+		++num_segments;
+	}
+	return num_segments;
+}
 
-	size_t hostlen = 0;
-	const char* ipv6_end = 0x0;
+URL_PARSER_LINKAGE const char* parse_url_query_decode( const char* src, size_t src_len, char* dst, size_t dst_size )
+{
+	if( src_len >= dst_size )
+		return 0x0;
 
-	if(url[0] == '[')
+	// ... decode the runs between '+' separately so that an encoded "%2B" is not turned into ' ' ...
+	const char* end   = src + src_len;
+	char*       write = dst;
+	while( true )
 	{
-		// ipv6 host is always enclosed in a [] to handle the : in an ipv6 address.
-		ipv6_end = strchr( url, ']' );
-		if(ipv6_end == 0x0)
+		const char* plus = (const char*)memchr( src, '+', (size_t)( end - src ) );
+		const char* stop = plus ? plus : end;
+
+		size_t len = parse_url_unescape_percent_encoding( write, src, (size_t)( stop - src ) );
+		if( len == PARSE_URL_NPOS )
 			return 0x0;
+		write += len;
+
+		if( plus == 0x0 )
+			break;
+		*write++ = ' ';
+		src = plus + 1;
 	}
+	*write = '\0';
+	return dst;
+}
+
+URL_PARSER_LINKAGE size_t parse_url_query_index_calc_mem_usage( size_t num_params )
+{
+	return PARSE_URL_ALIGNMENT - 1 + sizeof( parse_url_query_index ) + sizeof( unsigned int ) * parse_url_hash_num_slots( num_params );
+}
 
-	const char* portsep = strchr( ipv6_end ? ipv6_end + 1 : url, ':' );
-	const char* pathsep = strchr( ipv6_end ? ipv6_end + 1 : url, '/' );
+URL_PARSER_LINKAGE const parse_url_query_index* parse_url_query_index_build( const parsed_url_query_param* params, size_t num_params, void* mem, size_t mem_size )
+{
+	parse_url_ctx ctx = { mem, mem_size, mem_size };
+	return parse_url_alloc_query_index( &ctx, params, num_params );
+}
 
-	if( portsep == 0x0 )
+URL_PARSER_LINKAGE const parsed_url_query_param* parse_url_query_index_get( const parse_url_query_index* index, const char* key, size_t key_len )
+{
+	size_t slot = parse_url_hash_key( key, key_len ) & index->slot_mask;
+	for( unsigned int param_index; ( param_index = index->slots[slot] ) != 0; slot = ( slot + 1 ) & index->slot_mask )
 	{
-		hostlen = pathsep == 0x0 ? strlen( url ) : (size_t)( pathsep - url );
+		const parsed_url_query_param* param = index->params + param_index - 1;
+		if( param->key_len == key_len && memcmp( param->key, key, key_len ) == 0 )
+			return param;
 	}
-	else
+	return 0x0;
+}
+
+URL_PARSER_LINKAGE const parsed_url_query_param* parse_url_get_param( const parsed_url* parsed, const char* key )
+{
+	size_t key_len = strlen( key );
+	if( parsed->query_index )
+		return parse_url_query_index_get( parsed->query_index, key, key_len );
+
+	for( size_t i = 0; i < parsed->num_query_params; ++i )
 	{
-		if(pathsep && portsep && (pathsep < portsep))
-		{
-			// ... path separator was before port-separator, i.e. the : was not a port-separator! ...
-			hostlen = (size_t)( pathsep - url );
-		}
-		else
-		{
-			out->port = (unsigned int)atoi( portsep + 1 );
-			hostlen = (size_t)( portsep - url );
-			pathsep = strchr( portsep, '/' );
-		}
+		const parsed_url_query_param* param = parsed->query_params + i;
+		if( param->key_len == key_len && memcmp( param->key, key, key_len ) == 0 )
+			return param;
 	}
+	return 0x0;
+}
+
+URL_PARSER_LINKAGE size_t parse_url_scheme_table_calc_mem_usage( const parse_url_scheme_def* schemes, size_t num_schemes )
+{
+	size_t size = PARSE_URL_ALIGNMENT - 1 + sizeof( parse_url_scheme_table ) + sizeof( parse_url_scheme_def ) * num_schemes;
+	size += sizeof( unsigned int ) * parse_url_hash_num_slots( num_schemes );
+	for( size_t i = 0; i < num_schemes; ++i )
+		size += strlen( schemes[i].name ) + 1;
+	return size;
+}
+
+URL_PARSER_LINKAGE const parse_url_scheme_table* parse_url_scheme_table_build( const parse_url_scheme_def* schemes, size_t num_schemes, void* mem, size_t mem_size )
+{
+	parse_url_ctx ctx = { mem, mem_size, mem_size };
+	if( !parse_url_align_ctx( &ctx ) )
+		return 0x0;
+
+	size_t num_slots = parse_url_hash_num_slots( num_schemes );
+	parse_url_scheme_table* table = (parse_url_scheme_table*)parse_url_alloc_mem( &ctx, sizeof( parse_url_scheme_table ) );
+	parse_url_scheme_def*   defs  = (parse_url_scheme_def*)parse_url_alloc_mem( &ctx, sizeof( parse_url_scheme_def ) * num_schemes );
+	unsigned int*           slots = (unsigned int*)parse_url_alloc_mem( &ctx, sizeof( unsigned int ) * num_slots );
+	if( table == 0x0 || defs == 0x0 || slots == 0x0 )
+		return 0x0;
 
-	if( hostlen > 0 )
+	memset( slots, 0x0, sizeof( unsigned int ) * num_slots );
+	table->schemes     = defs;
+	table->num_schemes = num_schemes;
+	table->slots       = slots;
+	table->slot_mask   = num_slots - 1;
+
+	for( size_t i = 0; i < num_schemes; ++i )
 	{
-		if(ipv6_end)
-		{
-			// ... we have an ipv6 host, we need to strip of the []
-			out->host = parse_url_alloc_lower_string( ctx, url + 1, hostlen - 2 );
+		// ... a default port need to be a port that could be written in an url ...
+		if( schemes[i].default_port > 65535 )
+			return 0x0;
+
+		size_t len = strlen( schemes[i].name );
+		char* name = (char*)parse_url_alloc_mem( &ctx, len + 1 );
+		if( name == 0x0 )
+			return 0x0;
+		parse_url_copy_lower( name, schemes[i].name, len );
+		name[len] = '\0';
 
-			// ... verify that the host is actually a valid ipv6 address... I guess this
-			//     might miss one or two checks.
-			//     this only checks that it contains numbers or hex-chars or : or .
+		defs[i].name         = name;
+		defs[i].default_port = schemes[i].default_port;
 
-			for(const char* c = out->host; *c; ++c)
-			{
-				bool valid = parse_url_is_hex_char(*c) ||
-							 (*c == ':') ||
-							 (*c == '.');
-				if(!valid)
-					return 0x0;
-			}
+		size_t slot = parse_url_hash_scheme( name, len ) & table->slot_mask;
+		while( slots[slot] != 0 )
+			slot = ( slot + 1 ) & table->slot_mask;
+		slots[slot] = (unsigned int)( i + 1 );
+	}
+	return table;
+}
+
+URL_PARSER_LINKAGE void parse_url_set_scheme_table( const parse_url_scheme_table* table )
+{
+	parse_url_user_schemes = table;
+}
+
+struct parse_url_stream
+{
+	parsed_url_view   view;
+	parse_url_scanner scan;
+	char*             data;      // all bytes fed so far
+	size_t            data_size; // capacity of data
+	size_t            length;    // number of bytes fed so far
+	size_t            scanned;   // bytes before this has been handled by the scanner
+	bool              failed;
+	bool              finished;
+};
+
+/**
+ * Continue the scan of stream up to limit, any bytes after limit will be looked at on the next call.
+ */
+static bool parse_url_stream_scan( parse_url_stream* stream, size_t limit )
+{
+	if( stream->scanned < limit )
+	{
+		stream->scan.len = stream->length;
+		size_t next = parse_url_scan_range( &stream->scan, stream->scanned, limit, parse_url_delim_mask_kernel() );
+		if( next == PARSE_URL_NPOS )
+		{
+			stream->failed = true;
+			return false;
 		}
-		else
-			out->host = parse_url_alloc_lower_string( ctx, url, hostlen );
-		if(out->host == 0x0)
-			return 0x0;
+		stream->scanned = next;
 	}
+	return true;
+}
+
+URL_PARSER_LINKAGE size_t parse_url_stream_calc_mem_usage( size_t max_url_len )
+{
+	return PARSE_URL_ALIGNMENT - 1 + sizeof( parse_url_stream ) + max_url_len;
+}
+
+URL_PARSER_LINKAGE parse_url_stream* parse_url_stream_init( void* mem, size_t mem_size )
+{
+	if( mem == 0x0 )
+		return 0x0;
+
+	// ... the stream is placed at the first aligned address in mem, parse_url_stream_calc_mem_usage() has room for that ...
+	parse_url_ctx ctx = { mem, mem_size, mem_size };
+	if( !parse_url_align_ctx( &ctx ) )
+		return 0x0;
+
+	parse_url_stream* stream = (parse_url_stream*)parse_url_alloc_mem( &ctx, sizeof( parse_url_stream ) );
+	if( stream == 0x0 )
+		return 0x0;
+
+	memset( stream, 0x0, sizeof( parse_url_stream ) );
+	stream->data      = (char*)stream + sizeof( parse_url_stream );
+	stream->data_size = ctx.memleft;
+	stream->view.url  = stream->data;
+	parse_url_scan_init( &stream->scan, &stream->view, 0 );
+	return stream;
+}
+
+URL_PARSER_LINKAGE bool parse_url_stream_feed( parse_url_stream* stream, const char* data, size_t data_len )
+{
+	if( stream->failed || stream->finished )
+		return false;
 
-	// ... parse path ... TODO: extract to own function.
-	if( pathsep != 0x0 )
+	if( data_len > stream->data_size - stream->length )
 	{
-		// ... check if there are any query or fragment to parse ...
-		const char* path_end = strpbrk(pathsep, "?#");
+		stream->failed = true;
+		return false;
+	}
 
-		size_t reslen = 0;
-		if(path_end)
-			reslen = (size_t)(path_end - pathsep);
-		else
-			reslen = strlen( pathsep );
+	memcpy( stream->data + stream->length, data, data_len );
+	stream->length += data_len;
 
-		char* path = parse_url_alloc_string( ctx, pathsep, reslen );
-		if(path == 0x0)
-			return 0x0;
+	// ... delimiters look at most 2 bytes ahead, leave those to the next feed so that no decision depends on bytes not yet received ...
+	return stream->length < 2 || parse_url_stream_scan( stream, stream->length - 2 );
+}
 
-		out->path = parse_url_unescape_percent_encoding(path);
-		if(out->path == 0x0)
-			return 0x0;
+URL_PARSER_LINKAGE bool parse_url_stream_finish_view( parse_url_stream* stream, parsed_url_view* out )
+{
+	if( stream->failed )
+		return false;
+
+	if( !stream->finished )
+	{
+		if( !parse_url_stream_scan( stream, stream->length ) )
+			return false;
 
-		return pathsep + reslen;
+		if( !parse_url_scan_finish( &stream->scan, stream->length ) )
+		{
+			stream->failed = true;
+			return false;
+		}
+		stream->finished = true;
 	}
 
-	return url;
+	*out = stream->view;
+	return true;
 }
 
-static const char* parse_url_parse_query( const char* url, parse_url_ctx* ctx, parsed_url* out )
+URL_PARSER_LINKAGE parsed_url* parse_url_stream_finish( parse_url_stream* stream, void* usermem, size_t mem_size )
 {
-	// ... do we have a query? ...
-	if(*url != '?')
-		return url;
+	parsed_url_view view;
+	if( !parse_url_stream_finish_view( stream, &view ) )
+		return 0x0;
+	return parse_url_from_view( &view, usermem, mem_size );
+}
 
-	// ... skip '?' ...
-	++url;
+URL_PARSER_LINKAGE size_t parse_url_batch_calc_mem_usage( const char** urls, size_t num_urls )
+{
+	// ... each result is aligned for the next parsed_url, and the start of mem might need to be aligned as well ...
+	size_t size = PARSE_URL_ALIGNMENT - 1;
+	for( size_t i = 0; i < num_urls; ++i )
+		size += parse_url_align_up( parse_url_calc_mem_usage( urls[i] ) );
+	return size;
+}
 
-	// ... find the end of the query ...
-	size_t query_len = 0;
+URL_PARSER_LINKAGE size_t parse_url_batch( const char** urls, size_t num_urls, void* mem, size_t mem_size, parsed_url** out )
+{
+	parse_url_ctx ctx = {mem, mem_size, mem_size};
 
-	const char* fragment_start = strchr(url, '#');
-	if(fragment_start)
-		query_len = (size_t)(fragment_start - url);
-	else
-		query_len = strlen(url);
+	size_t num_parsed = 0;
+	for( size_t i = 0; i < num_urls; ++i )
+	{
+		out[i] = 0x0;
+
+		parsed_url_view view;
+		if( !parse_url_view( urls[i], &view ) )
+			continue;
 
-	out->query = parse_url_alloc_string( ctx, url, query_len );
-	return out->query == 0x0
-				? 0x0
-				: url + query_len;
+		// ... rewind the memory used by a url that did not fit so that it is not wasted ...
+		size_t memleft = ctx.memleft;
+		if( parse_url_align_ctx( &ctx ) )
+			out[i] = parse_url_from_view_ctx( &view, &ctx, 0 );
+
+		if( out[i] == 0x0 )
+			ctx.memleft = memleft;
+		else
+			++num_parsed;
+	}
+	return num_parsed;
 }
 
-static const char* parse_url_parse_fragment( const char* url, parse_url_ctx* ctx, parsed_url* out )
+/**
+ * Minimal work-stealing parallel-for used by parse_url_batch_parallel().
+ *
+ * Each worker owns a range of chunks packed as begin | end << 32 in one atomic. The owner pops
+ * chunks from the front of its range and when it runs dry it steals the upper half of the
+ * range of another worker.
+ */
+typedef void (*parse_url_parallel_func)( size_t chunk, void* userdata );
+
+#if !defined(URL_PARSER_NO_THREADS)
+struct parse_url_parallel_worker
 {
-	// ... do we have a fragment? ...
-	if(*url != '#')
-		return url;
+	std::atomic<uint64_t> range;
 
-	// ... skip '#' ...
-	++url;
+	// ... keep workers on separate cache-lines ...
+	char pad[64 - sizeof( std::atomic<uint64_t> )];
+};
 
-	size_t frag_len = strlen(url);
-	out->fragment = parse_url_alloc_string( ctx, url, frag_len );
+static uint64_t parse_url_parallel_range( uint64_t begin, uint64_t end )
+{
+	return begin | ( end << 32 );
+}
 
-	return out->fragment == 0x0
-				? 0x0
-				: url + frag_len;
+static bool parse_url_parallel_pop( parse_url_parallel_worker* worker, size_t* chunk )
+{
+	uint64_t range = worker->range.load( std::memory_order_relaxed );
+	while( true )
+	{
+		uint64_t begin = range & 0xFFFFFFFF;
+		uint64_t end   = range >> 32;
+		if( begin >= end )
+			return false;
+		if( worker->range.compare_exchange_weak( range, parse_url_parallel_range( begin + 1, end ), std::memory_order_acq_rel ) )
+		{
+			*chunk = (size_t)begin;
+			return true;
+		}
+	}
 }
 
-#define URL_PARSE_FAIL_IF( x ) \
-	if( x )                    \
-	{                          \
-		if( usermem == 0x0 )   \
-			free( mem );       \
-		return 0x0;            \
+static bool parse_url_parallel_steal( parse_url_parallel_worker* workers, unsigned int num_workers, unsigned int self, size_t* chunk )
+{
+	for( unsigned int i = 1; i < num_workers; ++i )
+	{
+		parse_url_parallel_worker* victim = &workers[( self + i ) % num_workers];
+		uint64_t range = victim->range.load( std::memory_order_relaxed );
+		while( true )
+		{
+			uint64_t begin = range & 0xFFFFFFFF;
+			uint64_t end   = range >> 32;
+			if( begin >= end )
+				break;
+
+			// ... leave the lower half to the victim, run the first stolen chunk and keep the rest ...
+			uint64_t mid = begin + ( end - begin ) / 2;
+			if( victim->range.compare_exchange_weak( range, parse_url_parallel_range( begin, mid ), std::memory_order_acq_rel ) )
+			{
+				// ... our own range is empty so no one else will touch it ...
+				workers[self].range.store( parse_url_parallel_range( mid + 1, end ), std::memory_order_release );
+				*chunk = (size_t)mid;
+				return true;
+			}
+		}
 	}
+	return false;
+}
 
-URL_PARSER_LINKAGE size_t parse_url_calc_mem_usage( const char* url )
+static void parse_url_parallel_worker_run( parse_url_parallel_worker* workers, unsigned int num_workers, unsigned int self, parse_url_parallel_func func, void* userdata )
 {
-	return sizeof( parsed_url ) + strlen( url ) + 7; // 7 == max number of '\0' terminate
+	size_t chunk;
+	while( parse_url_parallel_pop( &workers[self], &chunk ) || parse_url_parallel_steal( workers, num_workers, self, &chunk ) )
+		func( chunk, userdata );
 }
+#endif // !defined(URL_PARSER_NO_THREADS)
 
-URL_PARSER_LINKAGE parsed_url* parse_url( const char* url, void* usermem, size_t mem_size )
+static void parse_url_parallel_for( size_t num_chunks, unsigned int num_threads, parse_url_parallel_func func, void* userdata )
 {
-	void* mem = usermem;
-	if( mem == 0x0 )
+#if !defined(URL_PARSER_NO_THREADS)
+	if( num_threads > num_chunks )
+		num_threads = (unsigned int)num_chunks;
+
+	if( num_threads > 1 )
 	{
-		mem_size = parse_url_calc_mem_usage( url );
-		mem = malloc( mem_size );
+		parse_url_parallel_worker* workers = new parse_url_parallel_worker[num_threads];
+		for( unsigned int i = 0; i < num_threads; ++i )
+			workers[i].range.store( parse_url_parallel_range( num_chunks * i / num_threads, num_chunks * ( i + 1 ) / num_threads ), std::memory_order_relaxed );
+
+		// ... the calling thread is worker 0 ...
+		std::thread* threads = new std::thread[num_threads - 1];
+		for( unsigned int i = 1; i < num_threads; ++i )
+			threads[i - 1] = std::thread( parse_url_parallel_worker_run, workers, num_threads, i, func, userdata );
+		parse_url_parallel_worker_run( workers, num_threads, 0, func, userdata );
+		for( unsigned int i = 1; i < num_threads; ++i )
+			threads[i - 1].join();
+
+		delete[] threads;
+		delete[] workers;
+		return;
 	}
+#else
+	(void)num_threads;
+#endif
+	for( size_t chunk = 0; chunk < num_chunks; ++chunk )
+		func( chunk, userdata );
+}
 
-	parse_url_ctx ctx = {mem, mem_size, mem_size};
+// ... small enough to balance urls of very different length, big enough to not make stealing a cost ...
+static const size_t PARSE_URL_URLS_PER_CHUNK = 128;
 
-	parsed_url* out = (parsed_url*)parse_url_alloc_mem( &ctx, sizeof( parsed_url ) );
-	URL_PARSE_FAIL_IF( out == 0x0 );
+struct parse_url_parallel_batch
+{
+	const char** urls;
+	size_t       num_urls;
+	char*        mem;
+	size_t       mem_size;
+	parsed_url** out;
 
-	// ... set default values ...
-	memset(out, 0x0, sizeof(parsed_url));
-	out->host = "localhost";
-	out->path = "/";
+	// ... memory needed by each chunk during the sizing pass, then number of urls parsed by each chunk ...
+	size_t*      chunk_result;
 
-	url = parse_url_parse_scheme   ( url, &ctx, out ); URL_PARSE_FAIL_IF( url == 0x0 );
-	url = parse_url_parse_user_pass( url, &ctx, out ); URL_PARSE_FAIL_IF( url == 0x0 );
-	url = parse_url_parse_host_port( url, &ctx, out ); URL_PARSE_FAIL_IF( url == 0x0 );
-	url = parse_url_parse_query    ( url, &ctx, out ); URL_PARSE_FAIL_IF( url == 0x0 );
-	url = parse_url_parse_fragment ( url, &ctx, out ); URL_PARSE_FAIL_IF( url == 0x0 );
+	// ... start of each chunks part of mem, num_chunks + 1 entries ...
+	size_t*      chunk_offset;
+};
 
-	return out;
+static void parse_url_parallel_size_chunk( size_t chunk, void* userdata )
+{
+	parse_url_parallel_batch* batch = (parse_url_parallel_batch*)userdata;
+	size_t first = chunk * PARSE_URL_URLS_PER_CHUNK;
+	size_t count = batch->num_urls - first < PARSE_URL_URLS_PER_CHUNK ? batch->num_urls - first : PARSE_URL_URLS_PER_CHUNK;
+
+	size_t size = 0;
+	for( size_t i = first; i < first + count; ++i )
+		size += parse_url_align_up( parse_url_calc_mem_usage( batch->urls[i] ) );
+	batch->chunk_result[chunk] = size;
+}
+
+static void parse_url_parallel_parse_chunk( size_t chunk, void* userdata )
+{
+	parse_url_parallel_batch* batch = (parse_url_parallel_batch*)userdata;
+	size_t first = chunk * PARSE_URL_URLS_PER_CHUNK;
+	size_t count = batch->num_urls - first < PARSE_URL_URLS_PER_CHUNK ? batch->num_urls - first : PARSE_URL_URLS_PER_CHUNK;
+
+	size_t begin = batch->chunk_offset[chunk];
+	size_t end   = batch->chunk_offset[chunk + 1];
+	batch->chunk_result[chunk] = parse_url_batch( batch->urls + first, count, batch->mem + begin, end - begin, batch->out + first );
+}
+
+URL_PARSER_LINKAGE size_t parse_url_batch_parallel( const char** urls, size_t num_urls, void* mem, size_t mem_size, parsed_url** out, unsigned int num_threads )
+{
+	if( num_urls == 0 )
+		return 0;
+
+#if !defined(URL_PARSER_NO_THREADS)
+	if( num_threads == 0 )
+		num_threads = std::thread::hardware_concurrency();
+#endif
+
+	size_t num_chunks = ( num_urls + PARSE_URL_URLS_PER_CHUNK - 1 ) / PARSE_URL_URLS_PER_CHUNK;
+	size_t* chunk_data = (size_t*)URL_PARSER_MALLOC( sizeof( size_t ) * ( num_chunks * 2 + 1 ) );
+	if( chunk_data == 0x0 )
+		return parse_url_batch( urls, num_urls, mem, mem_size, out );
+
+	// ... start the first chunk aligned, parse_url_batch_calc_mem_usage() has room for that ...
+	size_t addr = (size_t)mem;
+	size_t pad  = parse_url_align_up( addr ) - addr;
+	if( pad > mem_size )
+		pad = mem_size;
+
+	parse_url_parallel_batch batch;
+	batch.urls         = urls;
+	batch.num_urls     = num_urls;
+	batch.mem          = (char*)mem + pad;
+	batch.mem_size     = mem_size - pad;
+	batch.out          = out;
+	batch.chunk_result = chunk_data;
+	batch.chunk_offset = chunk_data + num_chunks;
+
+	// ... size all chunks in parallel, and then place them one after the other in mem ...
+	parse_url_parallel_for( num_chunks, num_threads, parse_url_parallel_size_chunk, &batch );
+	batch.chunk_offset[0] = 0;
+	for( size_t chunk = 0; chunk < num_chunks; ++chunk )
+		batch.chunk_offset[chunk + 1] = batch.chunk_offset[chunk] + batch.chunk_result[chunk];
+
+	// ... not all chunks fit, fixed parts of mem would fail whole chunks where parse_url_batch() packs as many urls as fit ...
+	if( batch.chunk_offset[num_chunks] > batch.mem_size )
+	{
+		URL_PARSER_FREE( chunk_data );
+		return parse_url_batch( urls, num_urls, mem, mem_size, out );
+	}
+
+	parse_url_parallel_for( num_chunks, num_threads, parse_url_parallel_parse_chunk, &batch );
+
+	size_t num_parsed = 0;
+	for( size_t chunk = 0; chunk < num_chunks; ++chunk )
+		num_parsed += batch.chunk_result[chunk];
+
+	URL_PARSER_FREE( chunk_data );
+	return num_parsed;
 }
 #endif // defined(URL_PARSER_IMPLEMENTATION)
 
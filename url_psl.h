@@ -0,0 +1,489 @@
+/*
+ Simple, STB-style, lookup of public suffixes and registrable domains of hosts in parsed url:s, built on top of url.h.
+
+ compile with URL_PSL_IMPLEMENTATION defined for implementation.
+ compile with URL_PSL_IMPLEMENTATION_STATIC defined for static implementation.
+
+ version 1.0, July, 2021
+
+ Copyright (C) 2021- Fredrik Kihlander
+
+ This software is provided 'as-is', without any express or implied
+ warranty.  In no event will the authors be held liable for any damages
+ arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 3. This notice may not be removed or altered from any source distribution.
+
+ Fredrik Kihlander
+ */
+
+#ifndef URL_PSL_H_INCLUDED
+#define URL_PSL_H_INCLUDED
+
+#include "url.h"
+
+#if defined(URL_PSL_IMPLEMENTATION_STATIC)
+#  if !defined(URL_PSL_IMPLEMENTATION)
+#    define URL_PSL_IMPLEMENTATION
+#    define URL_PSL_LINKAGE static
+#  endif
+#else
+#    define URL_PSL_LINKAGE
+#endif
+
+/**
+ * A public suffix list, as found at https://publicsuffix.org/list/public_suffix_list.dat, compiled
+ * into a trie over the labels of the rules from the right by url_psl_build(). Placed in the memory
+ * passed to url_psl_build() and read-only after that, so it can be shared between threads.
+ */
+struct url_psl;
+
+/**
+ * Calculate the amount of memory needed to build a url_psl from list with url_psl_build().
+ *
+ * @param list content of a public suffix list file.
+ * @param list_len length of list in bytes.
+ */
+URL_PSL_LINKAGE size_t url_psl_calc_mem_usage(const char* list, size_t list_len);
+
+/**
+ * Build a url_psl from the content of a public suffix list file. Lines are rules, comments starting
+ * with "//" and empty lines are skipped and only the part of a line up to the first white-space is used.
+ * The list is copied and does not need to be kept alive.
+ *
+ * @param list content of a public suffix list file, as loaded from disk.
+ * @param list_len length of list in bytes.
+ * @param mem memory to build the url_psl in.
+ * @param mem_size size of mem, url_psl_calc_mem_usage() bytes is always enough.
+ *
+ * @return the url_psl or 0x0 if mem was to small.
+ */
+URL_PSL_LINKAGE const url_psl* url_psl_build(const char* list, size_t list_len, void* mem, size_t mem_size);
+
+/**
+ * Find the public suffix of host, such as "co.uk" in "www.example.co.uk", following the algorithm
+ * at https://publicsuffix.org/list/. A host matching no rule has its last label as public suffix.
+ *
+ * @note host is compared as is, it should be lower-cased as parsed_url::host and not be an ip-address,
+ *       see parsed_url::host_type. One trailing '.' is ignored.
+ *
+ * @param psl list to look in.
+ * @param host host to find public suffix of.
+ * @param host_len length of host in bytes.
+ * @param out set to the range of the public suffix in host.
+ *
+ * @return false if host is empty or contain empty labels.
+ */
+URL_PSL_LINKAGE bool url_psl_public_suffix(const url_psl* psl, const char* host, size_t host_len, parsed_url_range* out);
+
+/**
+ * Find the registrable domain of host, also called eTLD+1, i.e. the public suffix and one more label,
+ * such as "example.co.uk" in "www.example.co.uk". Nothing is copied or allocated.
+ *
+ * @param psl list to look in.
+ * @param host host to find registrable domain of, see url_psl_public_suffix().
+ * @param host_len length of host in bytes.
+ * @param out set to the range of the registrable domain in host.
+ *
+ * @return false if host has no registrable domain, i.e. host is a public suffix itself, or if
+ *         url_psl_public_suffix() fails.
+ */
+URL_PSL_LINKAGE bool url_psl_registrable_domain(const url_psl* psl, const char* host, size_t host_len, parsed_url_range* out);
+
+#if defined(URL_PSL_IMPLEMENTATION)
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum url_psl_node_flags
+{
+	URL_PSL_NODE_RULE      = 1 << 0, // labels up to and including this node is a rule, "co.uk".
+	URL_PSL_NODE_WILDCARD  = 1 << 1, // any label after this node is a rule, "*.ck".
+	URL_PSL_NODE_EXCEPTION = 1 << 2  // labels up to this node is not a rule even if matched by a wildcard, "!www.ck".
+};
+
+/**
+ * One node of the trie, one per unique label-suffix of the rules.
+ */
+struct url_psl_node
+{
+	uint32_t str;          // offset of the label matched by the node in url_psl::strings.
+	uint32_t str_len;
+	uint32_t first_child;  // children, stored sorted at nodes[first_child, first_child + num_children).
+	uint32_t num_children;
+	uint32_t flags;        // combination of url_psl_node_flags.
+};
+
+struct url_psl
+{
+	url_psl_node* nodes;
+	uint32_t      num_nodes;
+	char*         strings;
+	uint32_t      strings_used;
+};
+
+/**
+ * Rule being inserted during build, it is always the labels before 'end' that is left to insert.
+ */
+struct url_psl_build_rule
+{
+	const char* rule;
+	size_t      end;
+	uint32_t    flags;
+};
+
+/**
+ * Step to the label before end in str, labels are found from the right.
+ *
+ * @return false if there are no more labels.
+ */
+static bool url_psl_prev_label( const char* str, size_t* end, const char** label, size_t* label_len )
+{
+	if( *end == 0 )
+		return false;
+	size_t start = *end;
+	while( start > 0 && str[start - 1] != '.' )
+		--start;
+	*label     = str + start;
+	*label_len = *end - start;
+	*end       = start > 0 ? start - 1 : 0;
+	return true;
+}
+
+static int url_psl_compare_label( const char* a, size_t a_len, const char* b, size_t b_len )
+{
+	// ... shorter first, only needs to be a consistent order for the binary search ...
+	if( a_len != b_len )
+		return a_len < b_len ? -1 : 1;
+	return memcmp( a, b, a_len );
+}
+
+/**
+ * Sort rules label by label from the right, so that all rules that end up below the same node
+ * are next to each other and the rules ending at a node comes first.
+ */
+static int url_psl_compare_rules( const void* a_ptr, const void* b_ptr )
+{
+	const url_psl_build_rule* a = (const url_psl_build_rule*)a_ptr;
+	const url_psl_build_rule* b = (const url_psl_build_rule*)b_ptr;
+
+	size_t a_end = a->end;
+	size_t b_end = b->end;
+	while( true )
+	{
+		const char* a_label; size_t a_len;
+		const char* b_label; size_t b_len;
+		bool a_more = url_psl_prev_label( a->rule, &a_end, &a_label, &a_len );
+		bool b_more = url_psl_prev_label( b->rule, &b_end, &b_label, &b_len );
+		if( !a_more || !b_more )
+			return a_more == b_more ? 0 : ( a_more ? 1 : -1 );
+
+		int cmp = url_psl_compare_label( a_label, a_len, b_label, b_len );
+		if( cmp != 0 )
+			return cmp;
+	}
+}
+
+/**
+ * Iterate over the rules in list, return false when there are no more rules.
+ */
+static bool url_psl_next_rule( const char* list, size_t list_len, size_t* pos, const char** rule, size_t* rule_len )
+{
+	while( *pos < list_len )
+	{
+		const char* line     = list + *pos;
+		const char* line_end = (const char*)memchr( line, '\n', list_len - *pos );
+		if( line_end == 0x0 )
+			line_end = list + list_len;
+		*pos = (size_t)( line_end - list ) + 1;
+
+		// ... the rule is everything up to the first white-space ...
+		const char* end = line;
+		while( end < line_end && *end != ' ' && *end != '\t' && *end != '\r' )
+			++end;
+		if( end == line || ( end - line >= 2 && line[0] == '/' && line[1] == '/' ) )
+			continue;
+
+		*rule     = line;
+		*rule_len = (size_t)( end - line );
+		return true;
+	}
+	return false;
+}
+
+static void url_psl_count( const char* list, size_t list_len, size_t* num_rules, size_t* num_labels, size_t* num_chars )
+{
+	*num_rules  = 0;
+	*num_labels = 0;
+	*num_chars  = 0;
+
+	size_t      pos = 0;
+	const char* rule;
+	size_t      rule_len;
+	while( url_psl_next_rule( list, list_len, &pos, &rule, &rule_len ) )
+	{
+		++*num_rules;
+		*num_chars += rule_len;
+		for( size_t c = 0; c < rule_len; ++c )
+			if( rule[c] == '.' )
+				++*num_labels;
+		++*num_labels;
+	}
+}
+
+static uint32_t url_psl_add_string( url_psl* psl, const char* str, size_t len )
+{
+	uint32_t offset = psl->strings_used;
+	memcpy( psl->strings + offset, str, len );
+	psl->strings_used += (uint32_t)len;
+	return offset;
+}
+
+/**
+ * Fill in node from rules[begin, end), all rules in the range share the labels after their 'end'.
+ */
+static void url_psl_build_node( url_psl* psl, uint32_t node_index, url_psl_build_rule* rules, size_t begin, size_t end )
+{
+	url_psl_node* node = psl->nodes + node_index;
+	size_t        i    = begin;
+
+	// ... rules ending here ...
+	for( ; i < end && rules[i].end == 0; ++i )
+		node->flags |= rules[i].flags;
+
+	// ... one child per unique label, created before recursing to keep them next to each other.
+	//     first_child of the children holds where their rules start until they are built ...
+	node->first_child = psl->num_nodes;
+	for( size_t r = i; r < end; )
+	{
+		size_t      label_end = rules[r].end;
+		const char* label     = 0x0;
+		size_t      label_len = 0;
+		url_psl_prev_label( rules[r].rule, &label_end, &label, &label_len );
+
+		url_psl_node* child = psl->nodes + psl->num_nodes++;
+		child->str          = url_psl_add_string( psl, label, label_len );
+		child->str_len      = (uint32_t)label_len;
+		child->first_child  = (uint32_t)r;
+		child->num_children = 0;
+		child->flags        = 0;
+		++node->num_children;
+
+		// ... all rules with the same label goes below child, step past the label ...
+		const char* next_label = label;
+		size_t      next_len   = label_len;
+		while( r < end )
+		{
+			size_t next_end = rules[r].end;
+			url_psl_prev_label( rules[r].rule, &next_end, &next_label, &next_len );
+			if( url_psl_compare_label( label, label_len, next_label, next_len ) != 0 )
+				break;
+			rules[r++].end = next_end;
+		}
+	}
+
+	uint32_t first_child  = node->first_child;
+	uint32_t num_children = node->num_children;
+	for( uint32_t c = 0; c < num_children; ++c )
+	{
+		size_t child_begin = psl->nodes[first_child + c].first_child;
+		size_t child_end   = c + 1 < num_children ? psl->nodes[first_child + c + 1].first_child : end;
+		url_psl_build_node( psl, first_child + c, rules, child_begin, child_end );
+	}
+}
+
+static void* url_psl_alloc( uint8_t** mem, uint8_t* end, size_t size )
+{
+	uintptr_t aligned = ( (uintptr_t)*mem + sizeof( void* ) - 1 ) & ~(uintptr_t)( sizeof( void* ) - 1 );
+	if( aligned > (uintptr_t)end || size > (size_t)( (uintptr_t)end - aligned ) )
+		return 0x0;
+	*mem = (uint8_t*)aligned + size;
+	return (void*)aligned;
+}
+
+URL_PSL_LINKAGE size_t url_psl_calc_mem_usage( const char* list, size_t list_len )
+{
+	size_t num_rules, num_labels, num_chars;
+	url_psl_count( list, list_len, &num_rules, &num_labels, &num_chars );
+
+	return sizeof( url_psl ) +
+		   sizeof( url_psl_node ) * ( num_labels + 1 ) +
+		   sizeof( url_psl_build_rule ) * num_rules +
+		   num_chars +
+		   ( sizeof( void* ) - 1 ) * 4;
+}
+
+URL_PSL_LINKAGE const url_psl* url_psl_build( const char* list, size_t list_len, void* mem, size_t mem_size )
+{
+	size_t num_rules, num_labels, num_chars;
+	url_psl_count( list, list_len, &num_rules, &num_labels, &num_chars );
+
+	// ... everything used when looking up hosts is placed first, the rules used while building last ...
+	uint8_t* pos = (uint8_t*)mem;
+	uint8_t* end = pos + mem_size;
+	url_psl*            psl   = (url_psl*)           url_psl_alloc( &pos, end, sizeof( url_psl ) );
+	url_psl_node*       nodes = (url_psl_node*)      url_psl_alloc( &pos, end, sizeof( url_psl_node ) * ( num_labels + 1 ) );
+	char*               chars = (char*)              url_psl_alloc( &pos, end, num_chars );
+	url_psl_build_rule* rules = (url_psl_build_rule*)url_psl_alloc( &pos, end, sizeof( url_psl_build_rule ) * num_rules );
+	if( psl == 0x0 || nodes == 0x0 || chars == 0x0 || rules == 0x0 )
+		return 0x0;
+
+	psl->nodes        = nodes;
+	psl->num_nodes    = 1;
+	psl->strings      = chars;
+	psl->strings_used = 0;
+	memset( nodes, 0x0, sizeof( url_psl_node ) );
+
+	size_t      list_pos = 0;
+	size_t      r        = 0;
+	const char* rule;
+	size_t      rule_len;
+	while( url_psl_next_rule( list, list_len, &list_pos, &rule, &rule_len ) )
+	{
+		// ... "*.ck" is stored as a flag on "ck" and "!www.ck" as a flag on "www.ck" ...
+		uint32_t flags = URL_PSL_NODE_RULE;
+		if( rule_len >= 2 && rule[0] == '*' && rule[1] == '.' )
+		{
+			flags = URL_PSL_NODE_WILDCARD;
+			rule += 2;
+			rule_len -= 2;
+		}
+		else if( rule[0] == '!' )
+		{
+			flags = URL_PSL_NODE_EXCEPTION;
+			rule += 1;
+			rule_len -= 1;
+		}
+		rules[r].rule  = rule;
+		rules[r].end   = rule_len;
+		rules[r].flags = flags;
+		++r;
+	}
+
+	qsort( rules, num_rules, sizeof( url_psl_build_rule ), url_psl_compare_rules );
+	url_psl_build_node( psl, 0, rules, 0, num_rules );
+	return psl;
+}
+
+static uint32_t url_psl_find_child( const url_psl* psl, const url_psl_node* node, const char* label, size_t label_len )
+{
+	uint32_t lo = node->first_child;
+	uint32_t hi = node->first_child + node->num_children;
+	while( lo < hi )
+	{
+		uint32_t mid = lo + ( hi - lo ) / 2;
+		const url_psl_node* child = psl->nodes + mid;
+		int cmp = url_psl_compare_label( psl->strings + child->str, child->str_len, label, label_len );
+		if( cmp == 0 )
+			return mid;
+		if( cmp < 0 )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return 0;
+}
+
+/**
+ * Find the number of labels in the public suffix of host, or 0 on invalid host.
+ */
+static size_t url_psl_suffix_labels( const url_psl* psl, const char* host, size_t host_len )
+{
+	if( host_len == 0 || host[0] == '.' )
+		return 0;
+
+	// ... the implicit rule "*" makes the last label a public suffix if no other rule match ...
+	size_t              suffix = 1;
+	size_t              depth  = 0;
+	size_t              end    = host_len;
+	const url_psl_node* node   = psl->nodes;
+	const char*         label;
+	size_t              label_len;
+	while( url_psl_prev_label( host, &end, &label, &label_len ) )
+	{
+		if( label_len == 0 )
+			return 0;
+
+		uint32_t child = node == 0x0 ? 0 : url_psl_find_child( psl, node, label, label_len );
+		if( child != 0 && ( psl->nodes[child].flags & URL_PSL_NODE_EXCEPTION ) )
+		{
+			// ... an exception always wins, the suffix is the exception without its first label ...
+			suffix = depth;
+			node   = 0x0;
+		}
+		else if( node != 0x0 && ( node->flags & URL_PSL_NODE_WILDCARD ) && depth + 1 > suffix )
+			suffix = depth + 1;
+
+		node = child != 0 && node != 0x0 ? psl->nodes + child : 0x0;
+		++depth;
+		if( node != 0x0 && ( node->flags & URL_PSL_NODE_RULE ) && depth > suffix )
+			suffix = depth;
+
+		// ... when nothing more can match the rest of the labels are still walked, to find empty ones ...
+	}
+
+	// ... a wildcard can make the suffix longer than the host, "ck" for "*.ck" ...
+	return suffix > depth ? depth : suffix;
+}
+
+/**
+ * Range of the last num_labels labels of host.
+ */
+static parsed_url_range url_psl_last_labels( const char* host, size_t host_len, size_t num_labels )
+{
+	size_t start = host_len;
+	for( size_t l = 0; l < num_labels; ++l )
+	{
+		const char* label     = host;
+		size_t      label_len = 0;
+		url_psl_prev_label( host, &start, &label, &label_len );
+		if( l + 1 == num_labels )
+			start = (size_t)( label - host );
+	}
+	parsed_url_range range = { start, host_len - start };
+	return range;
+}
+
+static size_t url_psl_strip_trailing_dot( const char* host, size_t host_len )
+{
+	return host_len > 0 && host[host_len - 1] == '.' ? host_len - 1 : host_len;
+}
+
+URL_PSL_LINKAGE bool url_psl_public_suffix( const url_psl* psl, const char* host, size_t host_len, parsed_url_range* out )
+{
+	host_len = url_psl_strip_trailing_dot( host, host_len );
+	size_t suffix = url_psl_suffix_labels( psl, host, host_len );
+	if( suffix == 0 )
+		return false;
+	*out = url_psl_last_labels( host, host_len, suffix );
+	return true;
+}
+
+URL_PSL_LINKAGE bool url_psl_registrable_domain( const url_psl* psl, const char* host, size_t host_len, parsed_url_range* out )
+{
+	host_len = url_psl_strip_trailing_dot( host, host_len );
+	size_t suffix = url_psl_suffix_labels( psl, host, host_len );
+	if( suffix == 0 )
+		return false;
+
+	// ... the suffix and one more label, if there is one ...
+	parsed_url_range range = url_psl_last_labels( host, host_len, suffix );
+	if( range.offset == 0 )
+		return false;
+	*out = url_psl_last_labels( host, host_len, suffix + 1 );
+	return true;
+}
+
+#endif // defined(URL_PSL_IMPLEMENTATION)
+
+#endif // URL_PSL_H_INCLUDED
@@ -0,0 +1,555 @@
+/*
+ Simple, STB-style, router matching paths of parsed url:s against a set of routes, built on top of url.h.
+
+ compile with URL_ROUTER_IMPLEMENTATION defined for implementation.
+ compile with URL_ROUTER_IMPLEMENTATION_STATIC defined for static implementation.
+ compile with URL_ROUTER_MAX_PARAMS defined to change the max number of parameters in one route, default 16.
+
+ version 1.0, July, 2021
+
+ Copyright (C) 2021- Fredrik Kihlander
+
+ This software is provided 'as-is', without any express or implied
+ warranty.  In no event will the authors be held liable for any damages
+ arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 3. This notice may not be removed or altered from any source distribution.
+
+ Fredrik Kihlander
+ */
+
+#ifndef URL_ROUTER_H_INCLUDED
+#define URL_ROUTER_H_INCLUDED
+
+#include "url.h"
+
+#if defined(URL_ROUTER_IMPLEMENTATION_STATIC)
+#  if !defined(URL_ROUTER_IMPLEMENTATION)
+#    define URL_ROUTER_IMPLEMENTATION
+#    define URL_ROUTER_LINKAGE static
+#  endif
+#else
+#    define URL_ROUTER_LINKAGE
+#endif
+
+#if !defined(URL_ROUTER_MAX_PARAMS)
+#  define URL_ROUTER_MAX_PARAMS 16
+#endif
+
+/**
+ * A set of routes compiled into a trie over path segments by url_router_build(). Placed in the
+ * memory passed to url_router_build() and read-only after that, so it can be shared between threads.
+ *
+ * Routes are written as paths where a segment can be:
+ * "name"  - matches exactly that segment.
+ * ":name" - matches any one segment and captures it as parameter "name".
+ * "*name" - matches the rest of the path, can only be the last segment. The name is optional.
+ *
+ * for example "/api/v1/users/:id/posts" or "/static/" followed by "*file".
+ *
+ * Empty segments are ignored in both routes and paths, same as parse_url_path_next().
+ * If more than one route matches a path, exact segments are preferred over parameters and
+ * parameters over "*", segment by segment from the start of the path. Routes with the same
+ * segments, ignoring parameter names, are matched by the first one of them.
+ */
+struct url_router;
+
+/**
+ * One parameter captured when matching a route, such as "id" = "1234" for route "/users/:id"
+ * and path "/users/1234". name points into the router and value into the matched path, neither is
+ * '\0'-terminated.
+ */
+struct url_router_param
+{
+	const char* name;
+	size_t      name_len;
+	const char* value;
+	size_t      value_len;
+};
+
+/**
+ * Result of url_router_match().
+ */
+struct url_router_result
+{
+	/**
+	 * index of the matched route in the routes passed to url_router_build().
+	 */
+	size_t route;
+
+	/**
+	 * parameters captured by the route, in the order they are in the route.
+	 */
+	size_t           num_params;
+	url_router_param params[URL_ROUTER_MAX_PARAMS];
+};
+
+/**
+ * Calculate the amount of memory needed to build a router from routes with url_router_build().
+ *
+ * @param routes routes to build router for.
+ * @param num_routes number of routes in routes.
+ */
+URL_ROUTER_LINKAGE size_t url_router_calc_mem_usage(const char** routes, size_t num_routes);
+
+/**
+ * Build a router from routes into mem, the routes are copied and do not need to be kept alive.
+ *
+ * @param routes routes to build router for, see url_router for the syntax.
+ * @param num_routes number of routes in routes.
+ * @param mem memory to build the router in.
+ * @param mem_size size of mem, url_router_calc_mem_usage() bytes is always enough.
+ *
+ * @return the router or 0x0 if mem was to small, a route had more than URL_ROUTER_MAX_PARAMS
+ *         parameters or "*" was not the last segment of a route.
+ */
+URL_ROUTER_LINKAGE const url_router* url_router_build(const char** routes, size_t num_routes, void* mem, size_t mem_size);
+
+/**
+ * Match path against the routes in router, in time proportional to the number of segments in path
+ * as long as there is no need to backtrack from an exact segment to a parameter.
+ *
+ * @param router router to match against.
+ * @param path path to match, such as parsed_url::path.
+ * @param path_len length of path in bytes.
+ * @param result filled with the matched route and its parameters.
+ *
+ * @return false if no route matched path.
+ */
+URL_ROUTER_LINKAGE bool url_router_match(const url_router* router, const char* path, size_t path_len, url_router_result* result);
+
+#if defined(URL_ROUTER_IMPLEMENTATION)
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const uint32_t URL_ROUTER_NONE = 0xFFFFFFFF;
+
+/**
+ * One node of the trie, one node per unique path-prefix of the routes.
+ */
+struct url_router_node
+{
+	uint32_t str;            // offset of the segment matched by the node in url_router::strings, exact segments only.
+	uint32_t str_len;
+	uint32_t first_child;    // exact segment children, stored sorted at nodes[first_child, first_child + num_children).
+	uint32_t num_children;
+	uint32_t param_child;    // child that match any segment or URL_ROUTER_NONE.
+	uint32_t route;          // route ending at this node or URL_ROUTER_NONE.
+	uint32_t wildcard_route; // route with "*" after this node or URL_ROUTER_NONE.
+};
+
+struct url_router_route
+{
+	uint32_t first_param; // parameter names of route are at url_router::param_names[first_param, first_param + num_params).
+	uint32_t num_params;
+};
+
+struct url_router_param_name
+{
+	uint32_t str;
+	uint32_t str_len;
+};
+
+struct url_router
+{
+	url_router_node*       nodes;
+	uint32_t               num_nodes;
+	url_router_route*      routes;
+	url_router_param_name* param_names;
+	char*                  strings;
+	uint32_t               strings_used;
+};
+
+/**
+ * Route being inserted during build, it is always the segments after 'it' that is left to insert.
+ */
+struct url_router_build_route
+{
+	const char*         route;
+	size_t              route_len;
+	uint32_t            index;
+	parse_url_path_iter it;
+};
+
+enum url_router_segment_kind
+{
+	URL_ROUTER_SEGMENT_END,   // no more segments, sorted first so that the route ending at a node is found first.
+	URL_ROUTER_SEGMENT_EXACT,
+	URL_ROUTER_SEGMENT_PARAM,
+	URL_ROUTER_SEGMENT_WILDCARD
+};
+
+static url_router_segment_kind url_router_segment_kind_of( const parsed_url_path_segment* segment )
+{
+	switch( segment->str[0] )
+	{
+		case ':': return URL_ROUTER_SEGMENT_PARAM;
+		case '*': return URL_ROUTER_SEGMENT_WILDCARD;
+		default:  return URL_ROUTER_SEGMENT_EXACT;
+	}
+}
+
+static url_router_segment_kind url_router_peek( const url_router_build_route* route, parsed_url_path_segment* segment )
+{
+	parse_url_path_iter it = route->it;
+	if( !parse_url_path_next( &it, segment ) )
+		return URL_ROUTER_SEGMENT_END;
+	return url_router_segment_kind_of( segment );
+}
+
+static void url_router_skip( url_router_build_route* route )
+{
+	parsed_url_path_segment segment;
+	parse_url_path_next( &route->it, &segment );
+}
+
+static int url_router_compare_exact( const char* a, size_t a_len, const char* b, size_t b_len )
+{
+	// ... shorter first, only needs to be a consistent order for the binary search in the router ...
+	if( a_len != b_len )
+		return a_len < b_len ? -1 : 1;
+	return memcmp( a, b, a_len );
+}
+
+/**
+ * Sort routes segment by segment in the order children are stored in the trie, i.e. so that all
+ * routes that end up below the same node are next to each other.
+ */
+static int url_router_compare_routes( const void* a_ptr, const void* b_ptr )
+{
+	const url_router_build_route* a = (const url_router_build_route*)a_ptr;
+	const url_router_build_route* b = (const url_router_build_route*)b_ptr;
+
+	parse_url_path_iter a_it;
+	parse_url_path_iter b_it;
+	parse_url_path_iter_init( &a_it, a->route, a->route_len );
+	parse_url_path_iter_init( &b_it, b->route, b->route_len );
+	while( true )
+	{
+		parsed_url_path_segment a_seg;
+		parsed_url_path_segment b_seg;
+		int a_kind = parse_url_path_next( &a_it, &a_seg ) ? url_router_segment_kind_of( &a_seg ) : URL_ROUTER_SEGMENT_END;
+		int b_kind = parse_url_path_next( &b_it, &b_seg ) ? url_router_segment_kind_of( &b_seg ) : URL_ROUTER_SEGMENT_END;
+		if( a_kind != b_kind )
+			return a_kind < b_kind ? -1 : 1;
+		if( a_kind == URL_ROUTER_SEGMENT_END )
+			break;
+
+		if( a_kind == URL_ROUTER_SEGMENT_EXACT )
+		{
+			int cmp = url_router_compare_exact( a_seg.str, a_seg.len, b_seg.str, b_seg.len );
+			if( cmp != 0 )
+				return cmp;
+		}
+	}
+
+	// ... same route, keep the first one first ...
+	return a->index < b->index ? -1 : ( a->index > b->index ? 1 : 0 );
+}
+
+static uint32_t url_router_add_string( url_router* router, const char* str, size_t len )
+{
+	uint32_t offset = router->strings_used;
+	memcpy( router->strings + offset, str, len );
+	router->strings_used += (uint32_t)len;
+	return offset;
+}
+
+/**
+ * Fill in node from routes[begin, end), all routes in the range share the segments before their 'it'.
+ */
+static bool url_router_build_node( url_router* router, uint32_t node_index, url_router_build_route* routes, size_t begin, size_t end )
+{
+	url_router_node*        node = router->nodes + node_index;
+	parsed_url_path_segment segment;
+	size_t                  i    = begin;
+
+	// ... routes ending here, the first one wins ...
+	for( ; i < end && url_router_peek( &routes[i], &segment ) == URL_ROUTER_SEGMENT_END; ++i )
+		if( node->route == URL_ROUTER_NONE )
+			node->route = routes[i].index;
+
+	// ... exact segments, one child per unique segment ...
+	size_t exact_begin = i;
+	node->first_child  = router->num_nodes;
+	while( i < end && url_router_peek( &routes[i], &segment ) == URL_ROUTER_SEGMENT_EXACT )
+	{
+		url_router_node* child = router->nodes + router->num_nodes++;
+		child->str     = url_router_add_string( router, segment.str, segment.len );
+		child->str_len = (uint32_t)segment.len;
+		++node->num_children;
+
+		parsed_url_path_segment next;
+		while( i < end && url_router_peek( &routes[i], &next ) == URL_ROUTER_SEGMENT_EXACT &&
+			   url_router_compare_exact( segment.str, segment.len, next.str, next.len ) == 0 )
+			++i;
+	}
+
+	for( uint32_t c = 0; c < node->num_children; ++c )
+	{
+		// ... the routes for each child is found again, they are right after each other in the same order as the children ...
+		url_router_node* child = router->nodes + node->first_child + c;
+		size_t child_begin = exact_begin;
+		while( exact_begin < i && url_router_peek( &routes[exact_begin], &segment ) == URL_ROUTER_SEGMENT_EXACT &&
+			   url_router_compare_exact( router->strings + child->str, child->str_len, segment.str, segment.len ) == 0 )
+			url_router_skip( &routes[exact_begin++] );
+
+		if( !url_router_build_node( router, node->first_child + c, routes, child_begin, exact_begin ) )
+			return false;
+		node = router->nodes + node_index;
+	}
+
+	// ... parameters, all share one child ...
+	size_t param_begin = i;
+	for( ; i < end && url_router_peek( &routes[i], &segment ) == URL_ROUTER_SEGMENT_PARAM; ++i )
+		url_router_skip( &routes[i] );
+	if( i > param_begin )
+	{
+		node->param_child = router->num_nodes++;
+		if( !url_router_build_node( router, node->param_child, routes, param_begin, i ) )
+			return false;
+		node = router->nodes + node_index;
+	}
+
+	// ... and the rest of the path, that has to be the last segment ...
+	for( ; i < end; ++i )
+	{
+		url_router_skip( &routes[i] );
+		if( url_router_peek( &routes[i], &segment ) != URL_ROUTER_SEGMENT_END )
+			return false;
+		if( node->wildcard_route == URL_ROUTER_NONE )
+			node->wildcard_route = routes[i].index;
+	}
+	return true;
+}
+
+static void* url_router_alloc( uint8_t** mem, uint8_t* end, size_t size )
+{
+	uintptr_t aligned = ( (uintptr_t)*mem + sizeof( void* ) - 1 ) & ~(uintptr_t)( sizeof( void* ) - 1 );
+	if( aligned > (uintptr_t)end || size > (size_t)( (uintptr_t)end - aligned ) )
+		return 0x0;
+	*mem = (uint8_t*)aligned + size;
+	return (void*)aligned;
+}
+
+/**
+ * Count what is needed to build a router from routes.
+ */
+static void url_router_count( const char** routes, size_t num_routes, size_t* num_segments, size_t* num_params, size_t* num_chars )
+{
+	*num_segments = 0;
+	*num_params   = 0;
+	*num_chars    = 0;
+	for( size_t r = 0; r < num_routes; ++r )
+	{
+		parse_url_path_iter it;
+		parse_url_path_iter_init( &it, routes[r], strlen( routes[r] ) );
+		parsed_url_path_segment segment;
+		while( parse_url_path_next( &it, &segment ) )
+		{
+			++*num_segments;
+			*num_chars += segment.len;
+			if( url_router_segment_kind_of( &segment ) != URL_ROUTER_SEGMENT_EXACT )
+				++*num_params;
+		}
+	}
+}
+
+URL_ROUTER_LINKAGE size_t url_router_calc_mem_usage( const char** routes, size_t num_routes )
+{
+	size_t num_segments, num_params, num_chars;
+	url_router_count( routes, num_routes, &num_segments, &num_params, &num_chars );
+
+	return sizeof( url_router ) +
+		   sizeof( url_router_node ) * ( num_segments + 1 ) +
+		   sizeof( url_router_route ) * num_routes +
+		   sizeof( url_router_param_name ) * num_params +
+		   sizeof( url_router_build_route ) * num_routes +
+		   num_chars +
+		   ( sizeof( void* ) - 1 ) * 6;
+}
+
+URL_ROUTER_LINKAGE const url_router* url_router_build( const char** routes, size_t num_routes, void* mem, size_t mem_size )
+{
+	size_t num_segments, num_params, num_chars;
+	url_router_count( routes, num_routes, &num_segments, &num_params, &num_chars );
+
+	// ... everything used when matching is placed first, the routes used while building last ...
+	uint8_t* pos = (uint8_t*)mem;
+	uint8_t* end = pos + mem_size;
+	url_router*             router = (url_router*)            url_router_alloc( &pos, end, sizeof( url_router ) );
+	url_router_node*        nodes  = (url_router_node*)       url_router_alloc( &pos, end, sizeof( url_router_node ) * ( num_segments + 1 ) );
+	url_router_route*       info   = (url_router_route*)      url_router_alloc( &pos, end, sizeof( url_router_route ) * num_routes );
+	url_router_param_name*  names  = (url_router_param_name*) url_router_alloc( &pos, end, sizeof( url_router_param_name ) * num_params );
+	char*                   chars  = (char*)                  url_router_alloc( &pos, end, num_chars );
+	url_router_build_route* build  = (url_router_build_route*)url_router_alloc( &pos, end, sizeof( url_router_build_route ) * num_routes );
+	if( router == 0x0 || nodes == 0x0 || info == 0x0 || names == 0x0 || chars == 0x0 || build == 0x0 )
+		return 0x0;
+
+	router->nodes        = nodes;
+	router->num_nodes    = 1;
+	router->routes       = info;
+	router->param_names  = names;
+	router->strings      = chars;
+	router->strings_used = 0;
+
+	for( size_t n = 0; n < num_segments + 1; ++n )
+	{
+		nodes[n].str            = 0;
+		nodes[n].str_len        = 0;
+		nodes[n].first_child    = 0;
+		nodes[n].num_children   = 0;
+		nodes[n].param_child    = URL_ROUTER_NONE;
+		nodes[n].route          = URL_ROUTER_NONE;
+		nodes[n].wildcard_route = URL_ROUTER_NONE;
+	}
+
+	// ... parameter names are stored per route, they are not part of the trie ...
+	uint32_t param = 0;
+	for( size_t r = 0; r < num_routes; ++r )
+	{
+		info[r].first_param = param;
+		info[r].num_params  = 0;
+
+		parse_url_path_iter it;
+		parse_url_path_iter_init( &it, routes[r], strlen( routes[r] ) );
+		parsed_url_path_segment segment;
+		while( parse_url_path_next( &it, &segment ) )
+		{
+			if( url_router_segment_kind_of( &segment ) == URL_ROUTER_SEGMENT_EXACT )
+				continue;
+			if( info[r].num_params == URL_ROUTER_MAX_PARAMS )
+				return 0x0;
+			names[param].str     = url_router_add_string( router, segment.str + 1, segment.len - 1 );
+			names[param].str_len = (uint32_t)( segment.len - 1 );
+			++info[r].num_params;
+			++param;
+		}
+
+		build[r].route     = routes[r];
+		build[r].route_len = strlen( routes[r] );
+		build[r].index     = (uint32_t)r;
+		parse_url_path_iter_init( &build[r].it, build[r].route, build[r].route_len );
+	}
+
+	qsort( build, num_routes, sizeof( url_router_build_route ), url_router_compare_routes );
+	if( !url_router_build_node( router, 0, build, 0, num_routes ) )
+		return 0x0;
+	return router;
+}
+
+struct url_router_matcher
+{
+	const url_router*  router;
+	const char*        path_end;
+	url_router_result* result;
+	const char*        values[URL_ROUTER_MAX_PARAMS];
+	size_t             value_lens[URL_ROUTER_MAX_PARAMS];
+	size_t             num_values;
+};
+
+static uint32_t url_router_find_child( const url_router* router, const url_router_node* node, const parsed_url_path_segment* segment )
+{
+	uint32_t lo = node->first_child;
+	uint32_t hi = node->first_child + node->num_children;
+	while( lo < hi )
+	{
+		uint32_t mid = lo + ( hi - lo ) / 2;
+		const url_router_node* child = router->nodes + mid;
+		int cmp = url_router_compare_exact( router->strings + child->str, child->str_len, segment->str, segment->len );
+		if( cmp == 0 )
+			return mid;
+		if( cmp < 0 )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return URL_ROUTER_NONE;
+}
+
+static bool url_router_matched( url_router_matcher* m, uint32_t route )
+{
+	const url_router_route* info = m->router->routes + route;
+	m->result->route      = route;
+	m->result->num_params = info->num_params;
+	for( uint32_t p = 0; p < info->num_params; ++p )
+	{
+		const url_router_param_name* name = m->router->param_names + info->first_param + p;
+		m->result->params[p].name      = m->router->strings + name->str;
+		m->result->params[p].name_len  = name->str_len;
+		m->result->params[p].value     = m->values[p];
+		m->result->params[p].value_len = m->value_lens[p];
+	}
+	return true;
+}
+
+static bool url_router_match_node( url_router_matcher* m, uint32_t node_index, parse_url_path_iter it )
+{
+	const url_router_node* node = m->router->nodes + node_index;
+
+	parsed_url_path_segment segment;
+	if( !parse_url_path_next( &it, &segment ) )
+	{
+		if( node->route != URL_ROUTER_NONE )
+			return url_router_matched( m, node->route );
+
+		// ... "*" also match nothing ...
+		if( node->wildcard_route != URL_ROUTER_NONE )
+		{
+			m->values[m->num_values]     = m->path_end;
+			m->value_lens[m->num_values] = 0;
+			return url_router_matched( m, node->wildcard_route );
+		}
+		return false;
+	}
+
+	uint32_t child = url_router_find_child( m->router, node, &segment );
+	if( child != URL_ROUTER_NONE && url_router_match_node( m, child, it ) )
+		return true;
+
+	if( node->param_child != URL_ROUTER_NONE )
+	{
+		m->values[m->num_values]     = segment.str;
+		m->value_lens[m->num_values] = segment.len;
+		++m->num_values;
+		if( url_router_match_node( m, node->param_child, it ) )
+			return true;
+		--m->num_values;
+	}
+
+	if( node->wildcard_route != URL_ROUTER_NONE )
+	{
+		m->values[m->num_values]     = segment.str;
+		m->value_lens[m->num_values] = (size_t)( m->path_end - segment.str );
+		return url_router_matched( m, node->wildcard_route );
+	}
+	return false;
+}
+
+URL_ROUTER_LINKAGE bool url_router_match( const url_router* router, const char* path, size_t path_len, url_router_result* result )
+{
+	url_router_matcher m;
+	m.router     = router;
+	m.path_end   = path + path_len;
+	m.result     = result;
+	m.num_values = 0;
+
+	parse_url_path_iter it;
+	parse_url_path_iter_init( &it, path, path_len );
+	return url_router_match_node( &m, 0, it );
+}
+
+#endif // defined(URL_ROUTER_IMPLEMENTATION)
+
+#endif // URL_ROUTER_H_INCLUDED